@@ -0,0 +1,234 @@
+/*
+ * arc_length.hpp
+ *
+ * Header file for the arc length parameterization of Catmull-Rom splines
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_ARC_LENGTH_HPP
+#define CATMULL_ROS_ARC_LENGTH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+const int ARC_LENGTH_NEWTON_STEPS = 8;
+const double ARC_LENGTH_TOLERANCE = 1e-10;
+
+/*
+Five-point Gauss-Legendre quadrature nodes and weights on [-1, 1]
+*/
+const double GAUSS_LEGENDRE_NODES[5] = {
+	0.0, -0.5384693101056831, 0.5384693101056831,
+	-0.9061798459386640, 0.9061798459386640};
+const double GAUSS_LEGENDRE_WEIGHTS[5] = {
+	0.5688888888888889, 0.4786286704993665, 0.4786286704993665,
+	0.2369268850561891, 0.2369268850561891};
+
+/**
+Arc length of a Hermite segment between the parameters ta and tb
+*/
+inline double HermiteArcLength(ControlVertex& cv, double ta, double tb)
+{
+	const double half = 0.5*(tb - ta);
+	const double mid = 0.5*(tb + ta);
+	double sum = 0.0;
+	for (int k = 0; k < 5; k++)
+	{
+		const Vector3 v = cv.dhermite(mid + half*GAUSS_LEGENDRE_NODES[k]);
+		sum += GAUSS_LEGENDRE_WEIGHTS[k] * sqrt(Dot(v, v));
+	}
+	return sum*half;
+}
+
+/**
+ * catmull_ros::ArcLengthTable
+ *
+ * Cumulative arc length at the start of every segment of a constructed
+ * spline, to map between the spline parameter t and the arc length s.
+ * Inside a segment the length is integrated with Gauss-Legendre
+ * quadrature and inverted with Newton iterations.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class ArcLengthTable
+{
+private:
+	std::vector<ControlVertex*> segments;
+	// Pending knot shift of every segment (see CatmullSpline::GetKnotOffset)
+	std::vector<double> offset;
+	std::vector<double> t_start;
+	std::vector<double> t_end;
+	// cumulative[i]: arc length at the start of segment i
+	std::vector<double> cumulative;
+	std::uint64_t version;
+
+	/*
+	Refresh the segments from the spline, integrating the dirty ones
+	*/
+	void Refresh(CatmullSpline& spline, const std::vector<double>& lengths,
+		const std::vector<char>& dirty)
+	{
+		const int n = spline.GetNumberOfSegments();
+		segments.resize(n);
+		offset.resize(n);
+		t_start.resize(n);
+		t_end.resize(n);
+		cumulative.assign(n + 1, 0.0);
+		for (int i = 0; i < n; i++)
+		{
+			segments[i] = spline.GetControlVertex(i).get();
+			offset[i] = spline.GetKnotOffset(i);
+			t_start[i] = spline.GetSegmentStartT(i);
+			t_end[i] = spline.GetSegmentEndT(i);
+			const double length = dirty[i] ? HermiteArcLength(*segments[i], t_start[i] - offset[i],
+				t_end[i] - offset[i]) : lengths[i];
+			cumulative[i + 1] = cumulative[i] + length;
+		}
+		version = spline.GetVersion();
+	}
+public:
+	ArcLengthTable(): version(0)
+	{
+		cumulative.push_back(0.0);
+	}
+
+	explicit ArcLengthTable(CatmullSpline& spline)
+	{
+		Build(spline);
+	}
+
+	void Build(CatmullSpline& spline)
+	{
+		const int n = spline.GetNumberOfSegments();
+		Refresh(spline, std::vector<double>(n, 0.0), std::vector<char>(n, 1));
+	}
+
+	/**
+	Bring the table up to date with the local edits of the spline since it
+	was built: only the replaced segments are integrated again
+	*/
+	void Update(CatmullSpline& spline)
+	{
+		std::vector<SplineChange> changes;
+		if (!spline.GetChanges(version, changes))
+		{
+			Build(spline);
+			return;
+		}
+		if (changes.empty())
+		{
+			return;
+		}
+		std::vector<double> lengths(GetNumberOfSegments());
+		for (int i = 0; i < GetNumberOfSegments(); i++)
+		{
+			lengths[i] = SegmentLength(i);
+		}
+		std::vector<char> dirty(lengths.size(), 0);
+		for (std::size_t k = 0; k < changes.size(); k++)
+		{
+			const SplineChange& c = changes[k];
+			lengths.erase(lengths.begin() + c.first, lengths.begin() + c.first + c.removed);
+			lengths.insert(lengths.begin() + c.first, c.added, 0.0);
+			dirty.erase(dirty.begin() + c.first, dirty.begin() + c.first + c.removed);
+			dirty.insert(dirty.begin() + c.first, c.added, 1);
+		}
+		Refresh(spline, lengths, dirty);
+	}
+
+	int GetNumberOfSegments() const
+	{
+		return static_cast<int>(segments.size());
+	}
+
+	double TotalLength() const
+	{
+		return cumulative.back();
+	}
+
+	double SegmentLength(int i) const
+	{
+		return cumulative[i + 1] - cumulative[i];
+	}
+
+	/**
+	Arc length at the start of segment i
+	*/
+	double SegmentStart(int i) const
+	{
+		return cumulative[i];
+	}
+
+	/**
+	Arc length at parameter t of segment i
+	*/
+	double S(int i, double t) const
+	{
+		return cumulative[i] + HermiteArcLength(*segments[i], t_start[i] - offset[i], t - offset[i]);
+	}
+
+	/**
+	Arc length at parameter t (clamped to the parameter range)
+	*/
+	double S(double t) const
+	{
+		if (segments.empty())
+		{
+			return 0.0;
+		}
+		int i = static_cast<int>(std::upper_bound(t_start.begin(), t_start.end(), t)
+			- t_start.begin()) - 1;
+		i = std::max(0, i);
+		return S(i, std::min(t, t_end[i]));
+	}
+
+	/**
+	Segment and parameter at the arc length s (clamped to [0, length])
+	*/
+	void Invert(double s, int& segment, double& t) const
+	{
+		if (segments.empty())
+		{
+			segment = -1;
+			t = 0.0;
+			return;
+		}
+		s = std::max(0.0, std::min(TotalLength(), s));
+		int i = static_cast<int>(std::upper_bound(cumulative.begin(), cumulative.end(), s)
+			- cumulative.begin()) - 1;
+		i = std::max(0, std::min(GetNumberOfSegments() - 1, i));
+		const double length = SegmentLength(i);
+		double x = t_start[i];
+		if (length > 0.0)
+		{
+			x += (s - cumulative[i]) / length * (t_end[i] - t_start[i]);
+		}
+		for (int k = 0; k < ARC_LENGTH_NEWTON_STEPS; k++)
+		{
+			const double f = S(i, x) - s;
+			if (fabs(f) < ARC_LENGTH_TOLERANCE)
+			{
+				break;
+			}
+			const Vector3 v = segments[i]->dhermite(x - offset[i]);
+			const double speed = sqrt(Dot(v, v));
+			if (speed <= 0.0)
+			{
+				break;
+			}
+			x = std::max(t_start[i], std::min(t_end[i], x - f/speed));
+		}
+		segment = i;
+		t = x;
+	}
+};
+
+}
+#endif
@@ -8,13 +8,25 @@
 #ifndef CATMULL_H
 #define CATMULL_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <new>
+#include <utility>
+#include <vector>
 
 #include <iostream>
 
+#include <tbb/blocked_range.h>
 #include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
 
+#include "hermite_projection.hpp"
 #include "vector3.hpp"
 namespace catmull_ros
 {
@@ -85,15 +97,49 @@ public:
 	{
 		if (next!=nullptr)
 		{
-			double dtp1 = (next->T() - t);			
-			a2 = (3.0*(next->P() - p) / (dtp1*dtp1))
-				- (next->V() + 2.0*v) / (dtp1);
-			a3 = (2.0*(p - next->P()) / (dtp1*dtp1*dtp1)) 
-				+ (next->V() + v) / (dtp1*dtp1);
+			InitHermite(next->T() - t);
 		}
 		
 	}
 
+	/*
+	Initialize Hermite with the parameter span of the segment to the next
+	control vertex given explicitly
+	*/
+	void InitHermite(double dtp1)
+	{
+		a2 = (3.0*(next->P() - p) / (dtp1*dtp1))
+			- (next->V() + 2.0*v) / (dtp1);
+		a3 = (2.0*(p - next->P()) / (dtp1*dtp1*dtp1)) 
+			+ (next->V() + v) / (dtp1*dtp1);
+	}
+
+	/*
+	Clear the Hermite coefficients of a vertex ending the spline
+	*/
+	void ResetHermite()
+	{
+		a2 = Vector3();
+		a3 = Vector3();
+	}
+
+	void SetNeighbours(std::shared_ptr<ControlVertex> prev,
+		std::shared_ptr<ControlVertex> next)
+	{
+		this->prev = prev;
+		this->next = next;
+	}
+
+	void SetT(double t)
+	{
+		this->t = t;
+	}
+
+	void SetP(const Vector3& p)
+	{
+		this->p = p;
+	}
+
 	void InitializeLoop(std::shared_ptr<ControlVertex> prev,
 		std::shared_ptr<ControlVertex> next)
 	{
@@ -203,6 +249,14 @@ public:
 		return a3 * (dt*dt*dt) + a2 * dt*dt + v * dt + p;
 	}
 
+	/*
+	Parameter of the point closest to q on the segment ending at t_end
+	*/
+	double ClosestParameter(const Vector3& q, double t_end)
+	{
+		return t + ClosestHermiteParameter(p, v, a2, a3, t_end - t, q);
+	}
+
 	double T()
 	{
 		return t;
@@ -220,6 +274,68 @@ public:
 
 };
 
+/*
+Inputs at least this large are loaded in parallel by AddControlVertices
+*/
+const std::size_t CATMULL_PARALLEL_LOAD_THRESHOLD = 1 << 16;
+
+/*
+Contiguous storage of control vertices loaded in bulk: every vertex of
+the block shares its lifetime through aliasing shared pointers, so a
+bulk load costs one allocation instead of two per vertex
+*/
+struct ControlVertexBlock
+{
+	ControlVertex* data;
+	std::size_t size;
+
+	explicit ControlVertexBlock(std::size_t capacity):
+		data(static_cast<ControlVertex*>(::operator new(capacity*sizeof(ControlVertex)))),
+		size(0)
+	{
+	}
+
+	~ControlVertexBlock()
+	{
+		for (std::size_t i = 0; i < size; i++)
+		{
+			data[i].~ControlVertex();
+		}
+		::operator delete(data);
+	}
+};
+
+/*
+Local edits of splines with fewer control vertices rebuild the spline
+*/
+const int CATMULL_LOCAL_EDIT_MIN_VERTICES = 4;
+/*
+Pending knot shifts are applied to the vertices beyond this count (each
+knot lookup is a binary search over them)
+*/
+const std::size_t CATMULL_MAX_KNOT_SHIFTS = 32;
+/*
+Number of edits kept for the caches built on a spline
+*/
+const std::size_t CATMULL_CHANGE_LOG_SIZE = 256;
+
+/**
+ * catmull_ros::SplineChange
+ *
+ * Record of a local edit of a spline: the segments [first, first + removed)
+ * of the previous version were replaced by the segments [first, first + added).
+ * Every later segment kept its shape, its parameters were shifted by
+ * knot_shift.
+ */
+struct SplineChange
+{
+	std::uint64_t version;
+	int first;
+	int removed;
+	int added;
+	double knot_shift;
+};
+
 /**
  * catmull_ros::CatmullSpline
  * 
@@ -229,6 +345,11 @@ public:
  * - Zero order function to calculate position of the spline according to parameter t
  * - First-order derivative function to calculate tangential velocity at a given point of parameter
  * - Second-order derivative function to calculate tangential acceleration at a given point of parameter
+ * - Local edits (move, insert, remove a control vertex) recomputing the knots,
+ *   tangents and Hermite coefficients of the neighbourhood of the edit only,
+ *   with a versioned log of the changed segments. The later knots are
+ *   shifted lazily, but insert and remove still move the O(n) vertex
+ *   pointers after the edit
  * 
  * 
  * */
@@ -239,6 +360,291 @@ private:
 	double min_t;
 	double max_t;
 	bool closed;
+	// Knots shifted lazily by local edits, as prefix sums: the parameter
+	// of the i-th vertex is its T() plus the offset of the last entry with
+	// index up to i
+	std::vector<std::pair<int, double> > knot_shifts;
+	std::uint64_t version;
+	std::deque<SplineChange> changes;
+
+	double KnotOffset(int i) const
+	{
+		std::vector<std::pair<int, double> >::const_iterator it = std::upper_bound(
+			knot_shifts.begin(), knot_shifts.end(), std::make_pair(i, std::numeric_limits<double>::max()));
+		return it == knot_shifts.begin() ? 0.0 : (it - 1)->second;
+	}
+
+	/*
+	Parameter of the i-th control vertex, including pending shifts
+	*/
+	double KnotAt(int i) const
+	{
+		return vertices[i]->T() + KnotOffset(i);
+	}
+
+	void AddKnotShift(int i, double delta)
+	{
+		if (i >= static_cast<int>(vertices.size()) || delta == 0.0)
+		{
+			return;
+		}
+		std::vector<std::pair<int, double> >::iterator it = std::lower_bound(
+			knot_shifts.begin(), knot_shifts.end(), std::make_pair(i, -std::numeric_limits<double>::max()));
+		if (it == knot_shifts.end() || it->first != i)
+		{
+			it = knot_shifts.insert(it, std::make_pair(i, KnotOffset(i)));
+		}
+		for (; it != knot_shifts.end(); ++it)
+		{
+			it->second += delta;
+		}
+		if (knot_shifts.size() > CATMULL_MAX_KNOT_SHIFTS)
+		{
+			ApplyKnotShifts();
+		}
+	}
+
+	/*
+	Follow the vertex indices of the pending shifts after a vertex was
+	inserted at (step 1) or removed from (step -1) index i
+	*/
+	void RenumberKnotShifts(int i, int step)
+	{
+		std::vector<std::pair<int, double> > renumbered;
+		for (std::size_t k = 0; k < knot_shifts.size(); k++)
+		{
+			std::pair<int, double> shift = knot_shifts[k];
+			if (step > 0 ? shift.first >= i : shift.first > i)
+			{
+				shift.first += step;
+			}
+			if (!renumbered.empty() && renumbered.back().first == shift.first)
+			{
+				// The later entry includes the earlier one
+				renumbered.back().second = shift.second;
+			}
+			else if (shift.first < static_cast<int>(vertices.size()))
+			{
+				renumbered.push_back(shift);
+			}
+		}
+		knot_shifts.swap(renumbered);
+	}
+
+	/*
+	Distance between the (j - 1)-th and j-th control vertex defining the
+	knot of the latter, as in Construct() and ConstructLoop()
+	*/
+	double Chord(int j)
+	{
+		const Vector3 d = vertices[j]->P() - vertices[j - 1]->P();
+		if (!closed && j == static_cast<int>(vertices.size()) - 1)
+		{
+			return sqrt(d.coords[0]*d.coords[0] + d.coords[1]*d.coords[1]
+				+ d.coords[2]*d.coords[2]);
+		}
+		return sqrt(d.coords[0]*d.coords[0] + d.coords[1]*d.coords[1]);
+	}
+
+	/*
+	Index of the neighbourhood of an edit, -1 if it is outside of an open spline
+	*/
+	int LocalIndex(int j)
+	{
+		const int n = static_cast<int>(vertices.size());
+		if (closed)
+		{
+			return ((j % n) + n) % n;
+		}
+		return (j >= 0 && j < n) ? j : -1;
+	}
+
+	void UpdateRange()
+	{
+		const int n = static_cast<int>(vertices.size());
+		min_t = KnotAt(0);
+		max_t = KnotAt(n - 1);
+		if (closed)
+		{
+			const Vector3 d = vertices[0]->P() - vertices[n - 1]->P();
+			max_t += sqrt(d.coords[0]*d.coords[0] + d.coords[1]*d.coords[1]);
+		}
+	}
+
+	void Rebuild()
+	{
+		if (closed)
+		{
+			ConstructLoop();
+		}
+		else
+		{
+			Construct();
+		}
+	}
+
+	/*
+	Recompute the spline around the control vertex i after an edit: the
+	knots lo..hi (hi had the parameter anchor_t before the edit, the later
+	knots are shifted lazily), the tangents of the neighbours of i and the
+	Hermite coefficients of the segments using them. segment_delta is the
+	change of the number of segments
+	*/
+	void UpdateLocal(int i, int lo, int hi, double anchor_t, int segment_delta)
+	{
+		const int n = static_cast<int>(vertices.size());
+		for (int j = lo; j <= hi; j++)
+		{
+			const double t = j == 0 ? 0.0 : KnotAt(j - 1) + Chord(j);
+			vertices[j]->SetT(t - KnotOffset(j));
+		}
+		double knot_shift = 0.0;
+		if (hi + 1 < n)
+		{
+			knot_shift = KnotAt(hi) - anchor_t;
+			AddKnotShift(hi + 1, knot_shift);
+		}
+		for (int j = i - 1; j <= i + 1; j++)
+		{
+			const int k = LocalIndex(j);
+			if (k >= 0)
+			{
+				vertices[k]->SetNeighbours(
+					LocalIndex(k - 1) >= 0 ? vertices[LocalIndex(k - 1)] : nullptr,
+					LocalIndex(k + 1) >= 0 ? vertices[LocalIndex(k + 1)] : nullptr);
+			}
+		}
+		for (int j = i - 1; j <= i + 1; j++)
+		{
+			const int k = LocalIndex(j);
+			if (k >= 0)
+			{
+				vertices[k]->InitializeVelocity();
+			}
+		}
+		for (int j = i - 2; j <= i + 1; j++)
+		{
+			const int k = LocalIndex(j);
+			if (k < 0)
+			{
+				continue;
+			}
+			if (k + 1 < n)
+			{
+				vertices[k]->InitHermite(KnotAt(k + 1) - KnotAt(k));
+			}
+			else if (closed)
+			{
+				vertices[k]->InitHermiteClose();
+			}
+			else
+			{
+				vertices[k]->ResetHermite();
+			}
+		}
+		UpdateRange();
+		const int segments = GetNumberOfSegments();
+		SplineChange change;
+		change.version = ++version;
+		change.first = std::max(0, i - 2);
+		int last = std::min(segments - 1, i + 1);
+		if (closed && (i - 2 < 0 || i + 1 > segments - 1))
+		{
+			// The edit wraps around the loop
+			change.first = 0;
+			last = segments - 1;
+		}
+		change.added = last - change.first + 1;
+		change.removed = change.added - segment_delta;
+		change.knot_shift = knot_shift;
+		changes.push_back(change);
+		if (changes.size() > CATMULL_CHANGE_LOG_SIZE)
+		{
+			changes.pop_front();
+		}
+	}
+
+	/*
+	A full construction invalidates every cache built on the spline
+	*/
+	void ResetEdits()
+	{
+		knot_shifts.clear();
+		changes.clear();
+		version++;
+		min_t = std::numeric_limits<double>::max();
+		max_t = std::numeric_limits<double>::min();
+	}
+
+	template <typename Iterator, typename KnotIterator>
+	static void FillBlock(ControlVertex* data, Iterator points, KnotIterator knots,
+		bool has_knots, std::size_t n, std::random_access_iterator_tag)
+	{
+		if (n < CATMULL_PARALLEL_LOAD_THRESHOLD)
+		{
+			for (std::size_t i = 0; i < n; i++)
+			{
+				new (data + i) ControlVertex(points[i], has_knots ? knots[i] : 0.0);
+			}
+			return;
+		}
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n),
+			[&](const tbb::blocked_range<std::size_t>& range)
+			{
+				for (std::size_t i = range.begin(); i != range.end(); i++)
+				{
+					new (data + i) ControlVertex(points[i], has_knots ? knots[i] : 0.0);
+				}
+			});
+	}
+
+	template <typename Iterator, typename KnotIterator>
+	static void FillBlock(ControlVertex* data, Iterator points, KnotIterator knots,
+		bool has_knots, std::size_t n, std::forward_iterator_tag)
+	{
+		for (std::size_t i = 0; i < n; i++, ++points)
+		{
+			new (data + i) ControlVertex(*points, has_knots ? *knots : 0.0);
+			if (has_knots)
+			{
+				++knots;
+			}
+		}
+	}
+
+	/*
+	Append n control vertices constructed in place in a single block
+	*/
+	template <typename Iterator, typename KnotIterator>
+	void AppendBlock(Iterator points, KnotIterator knots, bool has_knots, std::size_t n)
+	{
+		if (n == 0)
+		{
+			return;
+		}
+		std::shared_ptr<ControlVertexBlock> block(new ControlVertexBlock(n));
+		FillBlock(block->data, points, knots, has_knots, n,
+			typename std::iterator_traits<Iterator>::iterator_category());
+		block->size = n;
+		const std::size_t first = vertices.size();
+		vertices.grow_by(n);
+		if (n < CATMULL_PARALLEL_LOAD_THRESHOLD)
+		{
+			for (std::size_t i = 0; i < n; i++)
+			{
+				vertices[first + i] = std::shared_ptr<ControlVertex>(block, block->data + i);
+			}
+			return;
+		}
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n),
+			[&](const tbb::blocked_range<std::size_t>& range)
+			{
+				for (std::size_t i = range.begin(); i != range.end(); i++)
+				{
+					vertices[first + i] = std::shared_ptr<ControlVertex>(block, block->data + i);
+				}
+			});
+	}
 public:
 	/**
 	Create our spline: the minimal and maximal t parameter
@@ -246,7 +652,8 @@ public:
 	*/
 	CatmullSpline():
 		min_t(std::numeric_limits<double>::max()),
-		max_t(std::numeric_limits<double>::min())
+		max_t(std::numeric_limits<double>::min()),
+		version(0)
 	{
 		closed = false;
 	}
@@ -256,20 +663,15 @@ public:
 	*/
 	Vector3 r(double t) 
 	{
-		for (int i = 0; i < vertices.size()-1; i++)
+		const int i = EvaluationSegment(t);
+		if (i >= 0)
 		{
-			if (vertices[i]->T()<=t && vertices[i+1]->T()>t) 
-			{
-				return vertices[i]->Hermite(t);
-			}
-		}
-		if (closed && vertices[vertices.size() - 1]->T() <= t && max_t > t)
-		{
-			return vertices[vertices.size() - 1]->Hermite(t);
+			return vertices[i]->Hermite(t - KnotOffset(i));
 		}
-		else if (!closed && vertices[vertices.size() - 1]->T() == t)
+		const int n = static_cast<int>(vertices.size());
+		if (!closed && n > 0 && KnotAt(n - 1) == t)
 		{
-			return vertices[vertices.size() - 1]->Hermite(max_t);
+			return vertices[n - 1]->Hermite(max_t - KnotOffset(n - 1));
 		}
 		
 		Vector3 res;
@@ -280,17 +682,10 @@ public:
 	*/
 	Vector3 ddr(double t)
 	{
-		for (int i = 0; i < vertices.size() - 1; i++)
+		const int i = EvaluationSegment(t);
+		if (i >= 0)
 		{
-			if (vertices[i]->T() <= t && vertices[i + 1]->T()>t)
-			{
-				return vertices[i]->ddhermite(t);
-			}
-		}
-		if (closed &&
-			vertices[vertices.size() - 1]->T() <= t && max_t > t)
-		{
-			return vertices[vertices.size() - 1]->ddhermite(t);
+			return vertices[i]->ddhermite(t - KnotOffset(i));
 		}
 		
 		Vector3 res;
@@ -302,24 +697,59 @@ public:
 	*/
 	Vector3 dr(double t)
 	{
-		for (int i = 0; i < vertices.size() - 1; i++)
-		{
-			if (vertices[i]->T() <= t && vertices[i + 1]->T()>t)
-			{
-				return vertices[i]->dhermite(t);
-			}
-		}
-		if (closed
-			&&	
-			vertices[vertices.size() - 1]->T() <= t && max_t > t)
+		const int i = EvaluationSegment(t);
+		if (i >= 0)
 		{
-				return vertices[vertices.size() - 1]->dhermite(t);
+			return vertices[i]->dhermite(t - KnotOffset(i));
 		}
 
 		Vector3 res;
 		return res;
 	}
 
+	/**
+	Evaluate the parameters t[0..n) at once (as r, dr and ddr, with a
+	single segment search per parameter). Coordinate k of the i-th result
+	goes to r[i*row_stride + k*col_stride], likewise for dr and ddr which
+	may be nullptr. The default strides write a packed array of Vector3 or
+	a row-major n x 3 matrix, row_stride=1, col_stride=n a column-major one
+	*/
+	void Evaluate(const double* t, std::size_t n, double* r, double* dr=nullptr,
+		double* ddr=nullptr, std::size_t row_stride=3, std::size_t col_stride=1)
+	{
+		const int last = static_cast<int>(vertices.size()) - 1;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			const int segment = EvaluationSegment(t[i]);
+			Vector3 p, v, a;
+			if (segment >= 0)
+			{
+				ControlVertex& cv = *vertices[segment];
+				const double local = t[i] - KnotOffset(segment);
+				p = cv.Hermite(local);
+				v = cv.dhermite(local);
+				a = cv.ddhermite(local);
+			}
+			else if (!closed && last >= 0 && KnotAt(last) == t[i])
+			{
+				p = vertices[last]->Hermite(max_t - KnotOffset(last));
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				const std::size_t offset = i*row_stride + k*col_stride;
+				r[offset] = p.coords[k];
+				if (dr != nullptr)
+				{
+					dr[offset] = v.coords[k];
+				}
+				if (ddr != nullptr)
+				{
+					ddr[offset] = a.coords[k];
+				}
+			}
+		}
+	}
+
 	/**
 	Add control vertex to the list of control vertices
 	This control vertex will be defined at the input position
@@ -344,13 +774,310 @@ public:
 	}
 
 	/**
-	Get the i-th control vertex
+	Reserve room for n additional control vertices
+	*/
+	void Reserve(std::size_t n)
+	{
+		vertices.reserve(vertices.size() + n);
+	}
+
+	/**
+	Add the control vertices of the point range [first, last) at once.
+	The vertices are constructed in place in one contiguous block, in
+	parallel for large random access ranges
+	*/
+	template <typename Iterator>
+	void AddControlVertices(Iterator first, Iterator last)
+	{
+		const double* no_knots = nullptr;
+		AppendBlock(first, no_knots, false,
+			static_cast<std::size_t>(std::distance(first, last)));
+	}
+
+	/**
+	Add the control vertices of the point range [first, last) at once,
+	with the parameters starting at knots (as AddControlVertex(p, t))
+	*/
+	template <typename Iterator, typename KnotIterator>
+	void AddControlVertices(Iterator first, Iterator last, KnotIterator knots)
+	{
+		AppendBlock(first, knots, true,
+			static_cast<std::size_t>(std::distance(first, last)));
+	}
+
+	/**
+	Add n control vertices from an array of points
+	*/
+	void AddControlVertices(const Vector3* points, std::size_t n)
+	{
+		AddControlVertices(points, points + n);
+	}
+
+	/**
+	Add n control vertices from an array of points and parameters
+	*/
+	void AddControlVertices(const Vector3* points, const double* knots, std::size_t n)
+	{
+		AddControlVertices(points, points + n, knots);
+	}
+
+	void AddControlVertices(const std::vector<Vector3>& points)
+	{
+		AddControlVertices(points.begin(), points.end());
+	}
+
+	/**
+	Get the i-th control vertex. While local edits leave knot shifts
+	pending, its T() and Hermite functions lag the spline parameter by
+	GetKnotOffset(i): use GetSegmentStartT(i) for its knot and evaluate it
+	at t - GetKnotOffset(i)
 	*/
 	std::shared_ptr<ControlVertex> GetControlVertex(int i)
 	{
 		return vertices[i];
 	}
 
+	/**
+	Parameter of the i-th control vertex (the start of the i-th segment),
+	including the pending knot shifts
+	*/
+	double GetSegmentStartT(int i) const
+	{
+		return KnotAt(i);
+	}
+
+	/**
+	Pending knot shift of the i-th control vertex, zero after ApplyKnotShifts()
+	*/
+	double GetKnotOffset(int i) const
+	{
+		return KnotOffset(i);
+	}
+
+	/**
+	Number of control vertices added to the spline
+	*/
+	int GetNumberOfControlVertices()
+	{
+		return static_cast<int>(vertices.size());
+	}
+
+	/**
+	Number of Hermite segments: a closed spline has an additional
+	segment from the last control vertex back to the first one
+	*/
+	int GetNumberOfSegments()
+	{
+		if (vertices.size() < 2)
+		{
+			return 0;
+		}
+		return closed ? static_cast<int>(vertices.size()) :
+			static_cast<int>(vertices.size()) - 1;
+	}
+
+	/**
+	Parameter at the end of the i-th Hermite segment
+	*/
+	double GetSegmentEndT(int i)
+	{
+		if (i + 1 < static_cast<int>(vertices.size()))
+		{
+			return KnotAt(i + 1);
+		}
+		return max_t;
+	}
+
+	/**
+	Index of the Hermite segment containing parameter t (binary search),
+	-1 if t is outside of the parameter range
+	*/
+	int FindSegment(double t)
+	{
+		const int segments = GetNumberOfSegments();
+		if (segments == 0 || t < KnotAt(0))
+		{
+			return -1;
+		}
+		const double end_t = GetSegmentEndT(segments - 1);
+		if (t >= end_t)
+		{
+			return (!closed && t == end_t) ? segments - 1 : -1;
+		}
+		int lo = 0;
+		int hi = segments - 1;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi + 1) / 2;
+			if (KnotAt(mid) <= t)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid - 1;
+			}
+		}
+		return lo;
+	}
+
+	/**
+	Segment evaluated by r, dr and ddr at parameter t: as FindSegment, but
+	the end of an open spline belongs to no segment
+	*/
+	int EvaluationSegment(double t)
+	{
+		const int i = FindSegment(t);
+		if (i >= 0 && !closed && i == GetNumberOfSegments() - 1 && t == GetSegmentEndT(i))
+		{
+			return -1;
+		}
+		return i;
+	}
+
+	/**
+	Write the pending knot shifts of local edits into the control vertices
+	(O(n) in the vertices after the first shift). This is the only place
+	besides the edits themselves where the knots are rewritten: it must not
+	run concurrently with any reader of the spline
+	*/
+	void ApplyKnotShifts()
+	{
+		if (knot_shifts.empty())
+		{
+			return;
+		}
+		double offset = 0.0;
+		std::size_t k = 0;
+		for (int i = knot_shifts[0].first; i < static_cast<int>(vertices.size()); i++)
+		{
+			while (k < knot_shifts.size() && knot_shifts[k].first <= i)
+			{
+				offset = knot_shifts[k].second;
+				k++;
+			}
+			vertices[i]->SetT(vertices[i]->T() + offset);
+		}
+		knot_shifts.clear();
+	}
+
+	/**
+	Version of the spline, incremented by every construction and edit
+	*/
+	std::uint64_t GetVersion()
+	{
+		return version;
+	}
+
+	/**
+	Collect the edits made after the given version. Returns false if they
+	are no longer known (the spline was constructed again or the log
+	overflowed), then caches have to be rebuilt
+	*/
+	bool GetChanges(std::uint64_t since, std::vector<SplineChange>& result)
+	{
+		result.clear();
+		if (since == version)
+		{
+			return true;
+		}
+		if (changes.empty() || since > version || changes.front().version > since + 1)
+		{
+			return false;
+		}
+		for (std::size_t k = 0; k < changes.size(); k++)
+		{
+			if (changes[k].version > since)
+			{
+				result.push_back(changes[k]);
+			}
+		}
+		return true;
+	}
+
+	/**
+	Move the i-th control vertex of a constructed spline to p, recomputing
+	only its neighbourhood
+	*/
+	void MoveControlVertex(int i, const Vector3& p)
+	{
+		const int n = static_cast<int>(vertices.size());
+		vertices[i]->SetP(p);
+		if (n < CATMULL_LOCAL_EDIT_MIN_VERTICES)
+		{
+			Rebuild();
+			return;
+		}
+		const int hi = std::min(i + 1, n - 1);
+		UpdateLocal(i, i, hi, KnotAt(hi), 0);
+	}
+
+	/**
+	Insert a control vertex at p as the i-th one (0 <= i <= number of
+	control vertices) of a constructed spline, recomputing only its
+	neighbourhood. The vertex pointers after i are moved, O(n - i)
+	*/
+	void InsertControlVertex(int i, const Vector3& p)
+	{
+		const int n = static_cast<int>(vertices.size());
+		const double anchor_t = i < n ? KnotAt(i) : 0.0;
+		std::shared_ptr<ControlVertex> cv(new ControlVertex(p));
+		vertices.push_back(cv);
+		for (int j = n; j > i; j--)
+		{
+			vertices[j] = vertices[j - 1];
+		}
+		vertices[i] = cv;
+		RenumberKnotShifts(i, 1);
+		if (n + 1 < CATMULL_LOCAL_EDIT_MIN_VERTICES)
+		{
+			Rebuild();
+			return;
+		}
+		// Appending to an open spline changes the knot rule of the former end
+		const int lo = (!closed && i == n) ? i - 1 : i;
+		UpdateLocal(i, lo, std::min(i + 1, n), anchor_t, 1);
+	}
+
+	/**
+	Remove the i-th control vertex of a constructed spline, recomputing
+	only its neighbourhood. The vertex pointers after i are moved, O(n - i)
+	*/
+	void RemoveControlVertex(int i)
+	{
+		const int n = static_cast<int>(vertices.size());
+		const double anchor_t = i + 1 < n ? KnotAt(i + 1) : 0.0;
+		std::shared_ptr<ControlVertex> cv = vertices[i];
+		for (int j = i; j + 1 < n; j++)
+		{
+			vertices[j] = vertices[j + 1];
+		}
+		vertices.resize(n - 1);
+		cv->SetNeighbours(nullptr, nullptr);
+		RenumberKnotShifts(i, -1);
+		if (n - 1 < CATMULL_LOCAL_EDIT_MIN_VERTICES)
+		{
+			if (n > 2)
+			{
+				Rebuild();
+			}
+			else
+			{
+				ResetEdits();
+			}
+			return;
+		}
+		const int m = n - 1;
+		// Removing the end of an open spline changes the knot rule of the new end
+		const int lo = (!closed && i == m) ? i - 1 : i;
+		UpdateLocal(i, lo, std::min(i, m - 1), anchor_t, -1);
+	}
+
+	bool IsClosed()
+	{
+		return closed;
+	}
+
 	double GetMinT()
 	{
 		return min_t;
@@ -387,6 +1114,7 @@ public:
 
 	void Construct()
 	{
+		ResetEdits();
 		if (vertices.size()!=1)
 		{
 			vertices[0]->InitializeStart(vertices[1]);
@@ -424,7 +1152,7 @@ public:
 	
 	void ConstructLoop()
 	{
-		
+		ResetEdits();
 		vertices[0]->InitializeLoop(vertices[vertices.size() - 1],
 			vertices[1]);
 		for (int i = 1; i < vertices.size()-1; i++)
@@ -0,0 +1,389 @@
+/*
+ * decimation.hpp
+ *
+ * Header file for the tolerance-driven control vertex decimation
+ * of Catmull-Rom splines
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_DECIMATION_HPP
+#define CATMULL_ROS_DECIMATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+// Initial parameter intervals of every segment compared
+const int DECIMATION_SAMPLES_PER_SEGMENT = 4;
+// Bisections of an initial interval before its bound is taken as is
+const int DECIMATION_MAX_BISECTIONS = 16;
+
+/**
+ * catmull_ros::DecimationResult
+ *
+ * Summary of a decimation run
+ * - max_error: upper bound of the Hausdorff distance between the original
+ *   and the decimated spline
+ * - compression_ratio: original control vertices per kept control vertex
+ */
+struct DecimationResult
+{
+	int original_vertices;
+	int decimated_vertices;
+	double max_error;
+	double compression_ratio;
+
+	DecimationResult(): original_vertices(0), decimated_vertices(0),
+		max_error(0.0), compression_ratio(1.0) {}
+};
+
+/**
+ * catmull_ros::SplineDecimator
+ *
+ * Removes control vertices of a constructed spline while keeping the
+ * rebuilt spline within a tolerance of the original.
+ *
+ * The removal is Douglas-Peucker-style, but the error is measured
+ * against the rebuilt spline instead of the polyline: starting from the
+ * end points, every segment of the candidate spline is compared with the
+ * part of the original it replaces and the worst control vertex is
+ * reinserted. Segments are evaluated in parallel, so each refinement pass
+ * splits all violating segments at once.
+ *
+ * The error of a candidate segment is an upper bound of the larger of the
+ * two directed distances between it and the original span. The distance
+ * of a point moving along a Hermite cubic changes at most by its speed, so
+ * a parameter interval is within the distance of its centre plus its
+ * half-width times a bound of the speed on it (as in SplineDistance, with
+ * parameter instead of arc length intervals); intervals are bisected until
+ * this bound is within the tolerance. Projections onto the other cubic
+ * that miss the closest point only overestimate the distance.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class SplineDecimator
+{
+private:
+	CatmullSpline& original;
+	double tolerance;
+	int n;
+	bool closed;
+
+	/*
+	Build a spline out of the kept control vertices of the original
+	*/
+	void BuildCandidate(const std::vector<int>& kept, CatmullSpline& candidate)
+	{
+		for (int i = 0; i < static_cast<int>(kept.size()); i++)
+		{
+			candidate.AddControlVertex(original.GetControlVertex(kept[i])->P());
+		}
+		if (closed)
+		{
+			candidate.ConstructLoop();
+		}
+		else
+		{
+			candidate.Construct();
+		}
+	}
+
+	/*
+	Distance of q from the j-th segment of the original
+	*/
+	double DistanceToOriginalSegment(const Vector3& q, int j)
+	{
+		std::shared_ptr<ControlVertex> cv = original.GetControlVertex(j);
+		const double t = cv->ClosestParameter(q,
+			original.GetSegmentEndT(j) - original.GetKnotOffset(j));
+		return Distance(cv->Hermite(t), q);
+	}
+
+	/*
+	Distance of q from the original span of segments [a, b)
+	searching only around the segment hint, which is updated
+	*/
+	double DistanceToOriginal(const Vector3& q, int a, int b, int& hint)
+	{
+		double best = std::numeric_limits<double>::max();
+		int best_j = hint;
+		const int first = std::max(a, hint - 1);
+		const int last = std::min(b - 1, hint + 2);
+		for (int j = first; j <= last; j++)
+		{
+			const double d = DistanceToOriginalSegment(q, j);
+			if (d < best)
+			{
+				best = d;
+				best_j = j;
+			}
+		}
+		hint = best_j;
+		return best;
+	}
+
+	/*
+	Upper bound of the distance of the points of the Hermite cubic of cv on
+	[t0, t1] to the other curve, given the distance of a point to it (or a
+	larger value), starting from the given number of equal intervals;
+	worst_t is the centre of the interval of the largest bound.
+	The speed on an interval of half-width w around c is at most
+	|cv'(c)| + w*max|cv''| at its ends, since cv'' is linear
+	*/
+	template<typename DistanceTo>
+	double SegmentErrorBound(ControlVertex& cv, double t0, double t1,
+		int spans, DistanceTo distance, double& worst_t)
+	{
+		struct Span
+		{
+			double c;
+			double w;
+			int depth;
+		};
+		double bound = 0.0;
+		worst_t = t0;
+		std::vector<Span> stack;
+		const double w0 = 0.5*(t1 - t0) / spans;
+		// Pushed in reverse, so the spans are visited in order
+		for (int s = spans - 1; s >= 0; s--)
+		{
+			const Span span = {t0 + (2*s + 1)*w0, w0, 0};
+			stack.push_back(span);
+		}
+		while (!stack.empty())
+		{
+			const Span span = stack.back();
+			stack.pop_back();
+			const double d = distance(cv.Hermite(span.c));
+			const Vector3 v = cv.dhermite(span.c);
+			const Vector3 a0 = cv.ddhermite(span.c - span.w);
+			const Vector3 a1 = cv.ddhermite(span.c + span.w);
+			const double speed = sqrt(Dot(v, v))
+				+ span.w*sqrt(std::max(Dot(a0, a0), Dot(a1, a1)));
+			const double upper = d + speed*span.w;
+			if (upper <= tolerance || d > tolerance || span.depth == DECIMATION_MAX_BISECTIONS)
+			{
+				if (upper > bound)
+				{
+					bound = upper;
+					worst_t = span.c;
+				}
+				continue;
+			}
+			const double w = 0.5*span.w;
+			const Span right = {span.c + w, w, span.depth + 1};
+			const Span left = {span.c - w, w, span.depth + 1};
+			stack.push_back(right);
+			stack.push_back(left);
+		}
+		return bound;
+	}
+
+	/*
+	Pick an original vertex next to segment j that is not yet kept
+	*/
+	int SplitVertex(int j, int a, int b, double t_ratio,
+		const std::vector<char>& is_kept)
+	{
+		const int left = j;
+		const int right = j + 1;
+		const bool left_free = left > a && left < b;
+		const bool right_free = right > a && right < b;
+		if (left_free && (!right_free || t_ratio < 0.5))
+		{
+			return left;
+		}
+		if (right_free)
+		{
+			return right;
+		}
+		// No interior vertex: the tangents at the kept ends differ from
+		// the original, which are fixed by inserting the outer neighbours
+		const int before = closed ? (a - 1 + n) % n : a - 1;
+		if (before >= 0 && !is_kept[before])
+		{
+			return before;
+		}
+		const int after = closed ? (b + 1) % n : b + 1;
+		if (after < n && !is_kept[after])
+		{
+			return after;
+		}
+		return -1;
+	}
+
+	/*
+	Error of the k-th candidate segment and the vertex to reinsert
+	*/
+	void EvaluateSegment(CatmullSpline& candidate, int k,
+		const std::vector<int>& kept, const std::vector<char>& is_kept,
+		double& error, int& split)
+	{
+		const int m = static_cast<int>(kept.size());
+		const int a = kept[k];
+		const int b = k + 1 < m ? kept[k + 1] : n;
+		std::shared_ptr<ControlVertex> cand = candidate.GetControlVertex(k);
+		const double cand_end = candidate.GetSegmentEndT(k);
+		error = 0.0;
+		split = -1;
+		int worst_j = a;
+		double worst_ratio = 0.0;
+		const auto to_candidate = [&](const Vector3& q)
+		{
+			return Distance(cand->Hermite(cand->ClosestParameter(q, cand_end)), q);
+		};
+		// Original -> candidate
+		for (int j = a; j < b; j++)
+		{
+			std::shared_ptr<ControlVertex> cv = original.GetControlVertex(j);
+			// Parameters of the vertex (without the pending knot shift)
+			const double t0 = cv->T();
+			const double t1 = original.GetSegmentEndT(j) - original.GetKnotOffset(j);
+			double worst_t;
+			const double d = SegmentErrorBound(*cv, t0, t1,
+				DECIMATION_SAMPLES_PER_SEGMENT, to_candidate, worst_t);
+			if (d > error)
+			{
+				error = d;
+				worst_j = j;
+				worst_ratio = t1 > t0 ? (worst_t - t0) / (t1 - t0) : 0.0;
+			}
+		}
+		// Candidate -> original, starting from a few spans per original
+		// segment visited in order, so the closest original segment is
+		// found next to the previous one
+		int hint = a;
+		const auto to_original = [&](const Vector3& q)
+		{
+			return DistanceToOriginal(q, a, b, hint);
+		};
+		double worst_t;
+		const double d = SegmentErrorBound(*cand, cand->T(), cand_end,
+			DECIMATION_SAMPLES_PER_SEGMENT * (b - a), to_original, worst_t);
+		if (d > error)
+		{
+			error = d;
+			// Original segment closest to the worst point
+			const Vector3 q = cand->Hermite(worst_t);
+			double best = std::numeric_limits<double>::max();
+			for (int j = a; j < b; j++)
+			{
+				const double dj = DistanceToOriginalSegment(q, j);
+				if (dj < best)
+				{
+					best = dj;
+					worst_j = j;
+				}
+			}
+			worst_ratio = 0.5;
+		}
+		if (error > tolerance)
+		{
+			split = SplitVertex(worst_j, a, b, worst_ratio, is_kept);
+		}
+	}
+
+public:
+	SplineDecimator(CatmullSpline& original, double tolerance):
+		original(original), tolerance(tolerance)
+	{
+		n = original.GetNumberOfControlVertices();
+		closed = original.IsClosed();
+	}
+
+	/**
+	Decimate the original spline into the (empty) output spline,
+	which is constructed the same way (open or loop) as the original
+	*/
+	DecimationResult Decimate(CatmullSpline& decimated)
+	{
+		DecimationResult result;
+		result.original_vertices = n;
+		std::vector<int> kept;
+		if ((!closed && n <= 2) || (closed && n <= 3))
+		{
+			for (int i = 0; i < n; i++)
+			{
+				kept.push_back(i);
+			}
+		}
+		else if (closed)
+		{
+			kept.push_back(0);
+			kept.push_back(n / 3);
+			kept.push_back(2 * n / 3);
+		}
+		else
+		{
+			kept.push_back(0);
+			kept.push_back(n - 1);
+		}
+		while (static_cast<int>(kept.size()) < n)
+		{
+			CatmullSpline candidate;
+			BuildCandidate(kept, candidate);
+			std::vector<char> is_kept(n, 0);
+			for (int i = 0; i < static_cast<int>(kept.size()); i++)
+			{
+				is_kept[kept[i]] = 1;
+			}
+			const int segments = candidate.GetNumberOfSegments();
+			std::vector<double> errors(segments, 0.0);
+			std::vector<int> splits(segments, -1);
+			tbb::parallel_for(tbb::blocked_range<int>(0, segments),
+				[&](const tbb::blocked_range<int>& range)
+				{
+					for (int k = range.begin(); k != range.end(); k++)
+					{
+						EvaluateSegment(candidate, k, kept, is_kept,
+							errors[k], splits[k]);
+					}
+				});
+			result.max_error = 0.0;
+			const std::size_t before = kept.size();
+			for (int k = 0; k < segments; k++)
+			{
+				result.max_error = std::max(result.max_error, errors[k]);
+				if (splits[k] >= 0 && !is_kept[splits[k]])
+				{
+					is_kept[splits[k]] = 1;
+					kept.push_back(splits[k]);
+				}
+			}
+			if (kept.size() == before)
+			{
+				break;
+			}
+			std::sort(kept.begin(), kept.end());
+		}
+		if (static_cast<int>(kept.size()) == n)
+		{
+			// Every vertex is kept: the rebuilt spline is the original
+			result.max_error = 0.0;
+		}
+		if (n == 0)
+		{
+			return result;
+		}
+		BuildCandidate(kept, decimated);
+		result.decimated_vertices = static_cast<int>(kept.size());
+		if (result.decimated_vertices > 0)
+		{
+			result.compression_ratio =
+				static_cast<double>(n) / result.decimated_vertices;
+		}
+		return result;
+	}
+};
+
+}
+#endif
@@ -0,0 +1,225 @@
+/*
+ * eigen_interop.hpp
+ *
+ * Header file for zero-copy Eigen views of vectors, sample arrays and
+ * the evaluation results of Catmull-Rom splines. Optional: the rest of
+ * the package does not depend on Eigen
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_EIGEN_INTEROP_HPP
+#define CATMULL_ROS_EIGEN_INTEROP_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "catmull.hpp"
+#include "vector3.hpp"
+
+namespace catmull_ros
+{
+
+static_assert(sizeof(Vector3) == sizeof(Eigen::Vector3d),
+	"Vector3 and Eigen::Vector3d must have the same size");
+
+typedef Eigen::Map<Eigen::Vector3d> Vector3Map;
+typedef Eigen::Map<const Eigen::Vector3d> ConstVector3Map;
+
+/**
+n x 3 sample matrix with the layout of an array of Vector3
+*/
+typedef Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> SampleMatrix;
+typedef Eigen::Map<SampleMatrix> SampleMap;
+typedef Eigen::Map<const SampleMatrix> ConstSampleMap;
+
+/**
+Hermite coefficients of the segments, one row per segment:
+a0 (x, y, z), a1, a2, a3
+*/
+typedef Eigen::Matrix<double, Eigen::Dynamic, 12, Eigen::RowMajor> CoefficientMatrix;
+
+/**
+View of a vector (or of a Hermite coefficient of a control vertex)
+*/
+inline Vector3Map AsEigen(Vector3& v)
+{
+	return Vector3Map(v.coords);
+}
+
+inline ConstVector3Map AsEigen(const Vector3& v)
+{
+	return ConstVector3Map(v.coords);
+}
+
+/**
+View of n packed vectors as an n x 3 matrix
+*/
+inline SampleMap AsEigen(Vector3* data, std::size_t n)
+{
+	return SampleMap(data->coords, n, 3);
+}
+
+inline ConstSampleMap AsEigen(const Vector3* data, std::size_t n)
+{
+	return ConstSampleMap(data->coords, n, 3);
+}
+
+inline SampleMap AsEigen(std::vector<Vector3>& samples)
+{
+	return SampleMap(samples.data()->coords, samples.size(), 3);
+}
+
+inline ConstSampleMap AsEigen(const std::vector<Vector3>& samples)
+{
+	return ConstSampleMap(samples.data()->coords, samples.size(), 3);
+}
+
+template <typename Derived>
+inline Vector3 ToVector3(const Eigen::MatrixBase<Derived>& v)
+{
+	EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, 3);
+	return Vector3(v(0), v(1), v(2));
+}
+
+/**
+ * catmull_ros::EigenRowIterator
+ *
+ * Random access iterator over the rows of an n x 3 expression, yielding
+ * Vector3 values, to load control vertices without an intermediate copy
+ */
+template <typename Derived>
+class EigenRowIterator
+{
+private:
+	const Derived* matrix;
+	std::ptrdiff_t row;
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef Vector3 value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const Vector3* pointer;
+	typedef Vector3 reference;
+
+	EigenRowIterator(const Derived& matrix, std::ptrdiff_t row): matrix(&matrix), row(row)
+	{
+	}
+
+	Vector3 operator*() const
+	{
+		return (*this)[0];
+	}
+
+	Vector3 operator[](std::ptrdiff_t i) const
+	{
+		return Vector3((*matrix)(row + i, 0), (*matrix)(row + i, 1), (*matrix)(row + i, 2));
+	}
+
+	EigenRowIterator& operator++()
+	{
+		row++;
+		return *this;
+	}
+
+	EigenRowIterator operator+(std::ptrdiff_t i) const
+	{
+		return EigenRowIterator(*matrix, row + i);
+	}
+
+	std::ptrdiff_t operator-(const EigenRowIterator& other) const
+	{
+		return row - other.row;
+	}
+
+	bool operator==(const EigenRowIterator& other) const
+	{
+		return row == other.row;
+	}
+
+	bool operator!=(const EigenRowIterator& other) const
+	{
+		return row != other.row;
+	}
+};
+
+/**
+Add the rows of an n x 3 matrix as control vertices (bulk load, see
+CatmullSpline::AddControlVertices)
+*/
+template <typename Derived>
+void AddControlVertices(CatmullSpline& spline, const Eigen::MatrixBase<Derived>& points)
+{
+	eigen_assert(points.cols() == 3);
+	const Derived& m = points.derived();
+	spline.AddControlVertices(EigenRowIterator<Derived>(m, 0),
+		EigenRowIterator<Derived>(m, m.rows()));
+}
+
+/**
+Evaluate the parameters t into caller-owned n x 3 matrices (row- or
+column-major, any strides with direct access) without temporaries. dr
+and ddr are skipped when they have no rows
+*/
+template <typename DerivedR, typename DerivedDR, typename DerivedDDR>
+void Evaluate(CatmullSpline& spline, const Eigen::Ref<const Eigen::VectorXd>& t,
+	const Eigen::MatrixBase<DerivedR>& r_out, const Eigen::MatrixBase<DerivedDR>& dr_out,
+	const Eigen::MatrixBase<DerivedDDR>& ddr_out)
+{
+	EIGEN_STATIC_ASSERT(static_cast<int>(DerivedR::Flags) & Eigen::DirectAccessBit,
+		THIS_METHOD_IS_ONLY_FOR_EXPRESSIONS_WITH_DIRECT_MEMORY_ACCESS_SUCH_AS_MAP_OR_PLAIN_MATRICES);
+	EIGEN_STATIC_ASSERT(static_cast<int>(DerivedDR::Flags) & Eigen::DirectAccessBit,
+		THIS_METHOD_IS_ONLY_FOR_EXPRESSIONS_WITH_DIRECT_MEMORY_ACCESS_SUCH_AS_MAP_OR_PLAIN_MATRICES);
+	EIGEN_STATIC_ASSERT(static_cast<int>(DerivedDDR::Flags) & Eigen::DirectAccessBit,
+		THIS_METHOD_IS_ONLY_FOR_EXPRESSIONS_WITH_DIRECT_MEMORY_ACCESS_SUCH_AS_MAP_OR_PLAIN_MATRICES);
+	// Writable views of the outputs (the usual Eigen idiom for output arguments)
+	DerivedR& r = const_cast<DerivedR&>(r_out.derived());
+	DerivedDR& dr = const_cast<DerivedDR&>(dr_out.derived());
+	DerivedDDR& ddr = const_cast<DerivedDDR&>(ddr_out.derived());
+	const std::size_t n = static_cast<std::size_t>(t.size());
+	eigen_assert(r.rows() == t.size() && r.cols() == 3);
+	eigen_assert(dr.rows() == 0 || (dr.rows() == t.size() && dr.cols() == 3));
+	eigen_assert(ddr.rows() == 0 || (ddr.rows() == t.size() && ddr.cols() == 3));
+	eigen_assert(dr.rows() == 0 || (dr.rowStride() == r.rowStride() && dr.colStride() == r.colStride()));
+	eigen_assert(ddr.rows() == 0 || (ddr.rowStride() == r.rowStride() && ddr.colStride() == r.colStride()));
+	spline.Evaluate(t.data(), n, r.data(), dr.rows() > 0 ? dr.data() : nullptr,
+		ddr.rows() > 0 ? ddr.data() : nullptr, r.rowStride(), r.colStride());
+}
+
+/**
+Evaluate the positions at the parameters t into a caller-owned n x 3
+matrix
+*/
+template <typename DerivedR>
+void Evaluate(CatmullSpline& spline, const Eigen::Ref<const Eigen::VectorXd>& t,
+	const Eigen::MatrixBase<DerivedR>& r_out)
+{
+	EIGEN_STATIC_ASSERT(static_cast<int>(DerivedR::Flags) & Eigen::DirectAccessBit,
+		THIS_METHOD_IS_ONLY_FOR_EXPRESSIONS_WITH_DIRECT_MEMORY_ACCESS_SUCH_AS_MAP_OR_PLAIN_MATRICES);
+	DerivedR& r = const_cast<DerivedR&>(r_out.derived());
+	eigen_assert(r.rows() == t.size() && r.cols() == 3);
+	spline.Evaluate(t.data(), static_cast<std::size_t>(t.size()), r.data(), nullptr, nullptr,
+		r.rowStride(), r.colStride());
+}
+
+/**
+Copy the Hermite coefficients of every segment into a (resized)
+coefficient matrix, which may be reused between calls
+*/
+inline void GetCoefficients(CatmullSpline& spline, CoefficientMatrix& coefficients)
+{
+	const int n = spline.GetNumberOfSegments();
+	coefficients.resize(n, 12);
+	for (int i = 0; i < n; i++)
+	{
+		std::shared_ptr<ControlVertex> cv = spline.GetControlVertex(i);
+		coefficients.block<1, 3>(i, 0) = AsEigen(cv->A0()).transpose();
+		coefficients.block<1, 3>(i, 3) = AsEigen(cv->A1()).transpose();
+		coefficients.block<1, 3>(i, 6) = AsEigen(cv->A2()).transpose();
+		coefficients.block<1, 3>(i, 9) = AsEigen(cv->A3()).transpose();
+	}
+}
+
+}
+#endif
@@ -0,0 +1,596 @@
+/*
+ * fitting.hpp
+ *
+ * Header file for least-squares fitting of Catmull-Rom splines
+ * to noisy point data (batch and streaming)
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_FITTING_HPP
+#define CATMULL_ROS_FITTING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+/*
+A data point couples the control vertices P(i-1) ... P(i+2) of its segment
+*/
+const int FITTING_BANDWIDTH = 3;
+
+/**
+ * catmull_ros::BandedNormalEquations
+ *
+ * Symmetric positive definite banded system A x = b with three
+ * right-hand sides (one per coordinate), solved with a banded Cholesky
+ * factorization in O(n).
+ *
+ * Row i of the factor only depends on rows 0..i of A, so after changes
+ * confined to the tail only the rows from the first modified one are
+ * refactored.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class BandedNormalEquations
+{
+private:
+	static const int W = FITTING_BANDWIDTH + 1;
+	int n;
+	int first_dirty;
+	// Lower band, a[i*W + k] = A(i, i-k)
+	std::vector<double> a;
+	std::vector<double> l;
+	std::vector<Vector3> b;
+	std::vector<Vector3> z;
+	std::vector<Vector3> x;
+public:
+	BandedNormalEquations(): n(0), first_dirty(0) {}
+
+	int Size() const
+	{
+		return n;
+	}
+
+	/**
+	Append rows (with zero coefficients) to the system
+	*/
+	void Resize(int size)
+	{
+		if (size > n)
+		{
+			first_dirty = std::min(first_dirty, n);
+		}
+		n = size;
+		a.resize(n*W, 0.0);
+		l.resize(n*W, 0.0);
+		b.resize(n);
+		z.resize(n);
+		x.resize(n);
+	}
+
+	/**
+	Add v to the coefficient A(i, j) = A(j, i)
+	*/
+	void Add(int i, int j, double v)
+	{
+		if (i < j)
+		{
+			std::swap(i, j);
+		}
+		a[i*W + (i - j)] += v;
+		first_dirty = std::min(first_dirty, i);
+	}
+
+	void AddRhs(int i, const Vector3& v)
+	{
+		b[i] += v;
+		first_dirty = std::min(first_dirty, i);
+	}
+
+	/**
+	Add the rank-one term w w^T (and w q to the right-hand side)
+	for the coefficients w of the rows idx
+	*/
+	void AddObservation(const int* idx, const double* w, int count,
+		const Vector3& q, double weight=1.0)
+	{
+		for (int r = 0; r < count; r++)
+		{
+			if (w[r] == 0.0)
+			{
+				continue;
+			}
+			AddRhs(idx[r], (weight*w[r])*q);
+			for (int c = 0; c <= r; c++)
+			{
+				Add(idx[r], idx[c], weight*w[r]*w[c]);
+			}
+		}
+	}
+
+	/**
+	Save (or restore) rows [from, n) of A and b, used for transient terms
+	*/
+	void SaveTail(int from, std::vector<double>& a_saved,
+		std::vector<Vector3>& b_saved) const
+	{
+		a_saved.assign(a.begin() + from*W, a.end());
+		b_saved.assign(b.begin() + from, b.end());
+	}
+
+	void RestoreTail(int from, const std::vector<double>& a_saved,
+		const std::vector<Vector3>& b_saved)
+	{
+		std::copy(a_saved.begin(), a_saved.end(), a.begin() + from*W);
+		std::copy(b_saved.begin(), b_saved.end(), b.begin() + from);
+		first_dirty = std::min(first_dirty, from);
+	}
+
+	/**
+	Refactor and solve from the first modified row.
+	Returns false if the system is not positive definite
+	*/
+	bool Solve()
+	{
+		for (int i = first_dirty; i < n; i++)
+		{
+			const int j0 = std::max(0, i - FITTING_BANDWIDTH);
+			for (int k = j0; k <= i; k++)
+			{
+				double sum = a[i*W + (i - k)];
+				for (int j = std::max(j0, k - FITTING_BANDWIDTH); j < k; j++)
+				{
+					sum -= l[i*W + (i - j)] * l[k*W + (k - j)];
+				}
+				if (k == i)
+				{
+					if (sum <= 0.0)
+					{
+						first_dirty = std::min(first_dirty, i);
+						return false;
+					}
+					l[i*W] = sqrt(sum);
+				}
+				else
+				{
+					l[i*W + (i - k)] = sum / l[k*W];
+				}
+			}
+			Vector3 sum = b[i];
+			for (int j = j0; j < i; j++)
+			{
+				sum -= l[i*W + (i - j)] * z[j];
+			}
+			z[i] = sum / l[i*W];
+		}
+		first_dirty = n;
+		for (int i = n - 1; i >= 0; i--)
+		{
+			Vector3 sum = z[i];
+			for (int j = i + 1; j <= std::min(n - 1, i + FITTING_BANDWIDTH); j++)
+			{
+				sum -= l[j*W + (j - i)] * x[j];
+			}
+			x[i] = sum / l[i*W];
+		}
+		return true;
+	}
+
+	const Vector3& X(int i) const
+	{
+		return x[i];
+	}
+
+	/**
+	Remove the first count unknowns, fixing them at their current
+	solution: their coupling to the remaining rows moves to the
+	right-hand side
+	*/
+	void EraseFront(int count)
+	{
+		for (int i = count; i < std::min(n, count + FITTING_BANDWIDTH); i++)
+		{
+			for (int k = i - FITTING_BANDWIDTH; k < count; k++)
+			{
+				if (k >= 0)
+				{
+					b[i] -= a[i*W + (i - k)] * x[k];
+					a[i*W + (i - k)] = 0.0;
+				}
+			}
+		}
+		a.erase(a.begin(), a.begin() + count*W);
+		l.erase(l.begin(), l.begin() + count*W);
+		b.erase(b.begin(), b.begin() + count);
+		z.erase(z.begin(), z.begin() + count);
+		x.erase(x.begin(), x.begin() + count);
+		n -= count;
+		first_dirty = 0;
+	}
+};
+
+/**
+Coefficients of P(i-1) ... P(i+2) in the position of segment i at local
+parameter u in [0, 1]. The knots are uniform and the tangents follow
+CatmullSpline: central differences inside, one-sided at the ends.
+first and last mark whether P(i) is the first and P(i+1) the last vertex
+*/
+inline void CatmullBasisWeights(double u, bool first, bool last, double* w)
+{
+	const double u2 = u*u;
+	const double u3 = u2*u;
+	const double h00 = 2.0*u3 - 3.0*u2 + 1.0;
+	const double h10 = u3 - 2.0*u2 + u;
+	const double h01 = -2.0*u3 + 3.0*u2;
+	const double h11 = u3 - u2;
+	w[0] = 0.0;
+	w[1] = h00;
+	w[2] = h01;
+	w[3] = 0.0;
+	if (first)
+	{
+		w[2] += h10;
+		w[1] -= h10;
+	}
+	else
+	{
+		w[2] += 0.5*h10;
+		w[0] -= 0.5*h10;
+	}
+	if (last)
+	{
+		w[2] += h11;
+		w[1] -= h11;
+	}
+	else
+	{
+		w[3] += 0.5*h11;
+		w[1] -= 0.5*h11;
+	}
+}
+
+/**
+Add the second-difference smoothness term centred on row j
+*/
+inline void AddSmoothnessTerm(BandedNormalEquations& system, int j, double smoothness)
+{
+	const int idx[3] = {j - 1, j, j + 1};
+	const double w[3] = {1.0, -2.0, 1.0};
+	system.AddObservation(idx, w, 3, Vector3(), smoothness);
+}
+
+/**
+ * catmull_ros::FitResult
+ *
+ * Outcome of a least-squares fit; the residuals are measured on the
+ * returned spline (see MeasureFitResiduals)
+ */
+struct FitResult
+{
+	bool success;
+	double rms_residual;
+	double max_residual;
+
+	FitResult(): success(false), rms_residual(0.0), max_residual(0.0) {}
+};
+
+/**
+Residuals of the samples (position along the control vertices, point)
+on the constructed spline: a point at position g is compared with r()
+at the fraction g - i of the knot interval of segment i = floor(g)
+*/
+template<typename Samples>
+inline void MeasureFitResiduals(const Samples& samples, CatmullSpline& spline,
+	FitResult& result)
+{
+	result.rms_residual = 0.0;
+	result.max_residual = 0.0;
+	const int segments = spline.GetNumberOfSegments();
+	if (segments == 0 || samples.empty())
+	{
+		return;
+	}
+	double sum = 0.0;
+	for (typename Samples::const_iterator it = samples.begin(); it != samples.end(); ++it)
+	{
+		const int i = std::max(0, std::min(segments - 1, static_cast<int>(floor(it->first))));
+		const double t0 = spline.GetSegmentStartT(i);
+		const double t = t0 + (it->first - i)*(spline.GetSegmentEndT(i) - t0);
+		const double d = Distance(spline.r(t), it->second);
+		sum += d*d;
+		result.max_residual = std::max(result.max_residual, d);
+	}
+	result.rms_residual = sqrt(sum / samples.size());
+}
+
+/**
+Fit the control vertices of spline (which shall be empty) to the ordered
+points, minimizing the squared distance plus smoothness times the squared
+second differences of the control vertices.
+
+The points are parameterized by their accumulated chord length and the
+vertices are placed uniformly along it, so the normal equations are
+banded and solved in O(n). The spline is then constructed as usual,
+which re-derives its knots and tangents from the fitted vertices: the
+result is measured on that spline, not on the uniform fitting model.
+*/
+inline FitResult FitSpline(const std::vector<Vector3>& points, int n_vertices,
+	double smoothness, CatmullSpline& spline)
+{
+	FitResult result;
+	const int m = n_vertices;
+	if (m < 2 || points.size() < 2)
+	{
+		return result;
+	}
+	std::vector<double> s(points.size(), 0.0);
+	for (std::size_t i = 1; i < points.size(); i++)
+	{
+		s[i] = s[i - 1] + Distance(points[i], points[i - 1]);
+	}
+	if (s.back() <= 0.0)
+	{
+		return result;
+	}
+	const double h = s.back() / (m - 1);
+	BandedNormalEquations system;
+	system.Resize(m);
+	std::vector<std::pair<double, Vector3> > samples(points.size());
+	for (std::size_t p = 0; p < points.size(); p++)
+	{
+		int i = std::min(static_cast<int>(s[p] / h), m - 2);
+		double w[4];
+		const double u = s[p] / h - i;
+		CatmullBasisWeights(u, i == 0, i + 1 == m - 1, w);
+		int idx[4] = {i - 1, i, i + 1, i + 2};
+		if (i == 0)
+		{
+			idx[0] = 0;
+		}
+		if (i + 2 > m - 1)
+		{
+			idx[3] = m - 1;
+		}
+		system.AddObservation(idx, w, 4, points[p]);
+		samples[p] = std::make_pair(i + u, points[p]);
+	}
+	for (int j = 1; j < m - 1; j++)
+	{
+		AddSmoothnessTerm(system, j, smoothness);
+	}
+	if (!system.Solve())
+	{
+		return result;
+	}
+	for (int j = 0; j < m; j++)
+	{
+		spline.AddControlVertex(system.X(j));
+	}
+	spline.Construct();
+	MeasureFitResiduals(samples, spline, result);
+	result.success = true;
+	return result;
+}
+
+/**
+ * catmull_ros::StreamingSplineFitter
+ *
+ * Sliding-window variant of FitSpline for sensor-rate input.
+ *
+ * Control vertices are spaced uniformly along the accumulated chord
+ * length of the incoming points. The normal equations are updated in
+ * place as points arrive; segments are sealed once their tangents no
+ * longer depend on the last vertex, the open tail segment is added
+ * transiently for each solve. Since only the tail changes, Solve()
+ * refactors just the last few rows.
+ *
+ * When the window is full its older half is retired: those vertices are
+ * frozen at their current solution (fixed-lag smoothing) and the
+ * refactorization of the window is amortized over window/2 vertices.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class StreamingSplineFitter
+{
+private:
+	double spacing;
+	double smoothness;
+	int window;
+	// Global index of the first vertex of the window
+	int offset;
+	double s;
+	Vector3 last_point;
+	bool has_points;
+	bool solved;
+	BandedNormalEquations system;
+	// Points of the open tail segment: (global chord length, position)
+	std::vector<std::pair<double, Vector3> > tail;
+	// Points of the segments of the window, for the residuals
+	std::deque<std::pair<double, Vector3> > window_points;
+	std::vector<Vector3> retired;
+	std::vector<double> a_saved;
+	std::vector<Vector3> b_saved;
+
+	void Accumulate(double s_point, const Vector3& q, bool last)
+	{
+		const int m = system.Size();
+		const int global = std::min(static_cast<int>(s_point / spacing), offset + m - 2);
+		const int i = global - offset;
+		double w[4];
+		CatmullBasisWeights(s_point / spacing - global, global == 0, last, w);
+		int idx[4] = {i - 1, i, i + 1, i + 2};
+		for (int k = 0; k < 4; k++)
+		{
+			idx[k] = std::max(0, std::min(m - 1, idx[k]));
+		}
+		system.AddObservation(idx, w, 4, q);
+	}
+
+	void AppendVertex()
+	{
+		const int m = system.Size() + 1;
+		system.Resize(m);
+		// The former tail segment is now interior
+		for (std::size_t p = 0; p < tail.size(); p++)
+		{
+			Accumulate(tail[p].first, tail[p].second, false);
+		}
+		tail.clear();
+		if (m >= 3)
+		{
+			AddSmoothnessTerm(system, m - 2, smoothness);
+		}
+		solved = false;
+	}
+
+	void Retire()
+	{
+		const int count = window / 2;
+		if (!solved && !Solve())
+		{
+			return;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			retired.push_back(system.X(i));
+		}
+		system.EraseFront(count);
+		offset += count;
+		while (!window_points.empty() && window_points.front().first < offset*spacing)
+		{
+			window_points.pop_front();
+		}
+		solved = false;
+	}
+
+public:
+	/**
+	Create a fitter with the given control vertex spacing and smoothness
+	weight, keeping at most window (at least 8) vertices active
+	*/
+	StreamingSplineFitter(double spacing, double smoothness, int window=64):
+		spacing(spacing), smoothness(smoothness),
+		window(std::max(8, window)), offset(0), s(0.0),
+		has_points(false), solved(false)
+	{
+	}
+
+	/**
+	Add the next point of the stream
+	*/
+	void AddPoint(const Vector3& q)
+	{
+		if (has_points)
+		{
+			s += Distance(q, last_point);
+		}
+		else
+		{
+			system.Resize(1);
+			AppendVertex();
+			has_points = true;
+		}
+		last_point = q;
+		while (static_cast<int>(s / spacing) >= offset + system.Size() - 1)
+		{
+			AppendVertex();
+			if (system.Size() > window)
+			{
+				Retire();
+			}
+		}
+		tail.push_back(std::make_pair(s, q));
+		window_points.push_back(std::make_pair(s, q));
+		solved = false;
+	}
+
+	/**
+	Update the fit of the window: returns false until there is enough data
+	*/
+	bool Solve()
+	{
+		if (!has_points)
+		{
+			return false;
+		}
+		const int from = std::max(0, system.Size() - FITTING_BANDWIDTH);
+		system.SaveTail(from, a_saved, b_saved);
+		for (std::size_t p = 0; p < tail.size(); p++)
+		{
+			Accumulate(tail[p].first, tail[p].second, true);
+		}
+		solved = system.Solve();
+		system.RestoreTail(from, a_saved, b_saved);
+		return solved;
+	}
+
+	int GetNumberOfWindowVertices() const
+	{
+		return system.Size();
+	}
+
+	/**
+	Global index of the first control vertex of the window
+	*/
+	int GetWindowOffset() const
+	{
+		return offset;
+	}
+
+	/**
+	i-th control vertex of the window, as of the last Solve()
+	*/
+	Vector3 GetWindowVertex(int i) const
+	{
+		return system.X(i);
+	}
+
+	/**
+	Hand over the vertices frozen since the last call
+	*/
+	std::vector<Vector3> TakeRetiredVertices()
+	{
+		std::vector<Vector3> res;
+		res.swap(retired);
+		return res;
+	}
+
+	/**
+	Build the spline of the current window into the (empty) spline, with
+	the residuals of the points of the window measured on it (as FitSpline
+	it re-derives the knots and tangents); fails unless the last Solve() did
+	*/
+	FitResult BuildSpline(CatmullSpline& spline) const
+	{
+		FitResult result;
+		for (int i = 0; i < system.Size(); i++)
+		{
+			spline.AddControlVertex(system.X(i));
+		}
+		spline.Construct();
+		if (!solved)
+		{
+			return result;
+		}
+		std::vector<std::pair<double, Vector3> > samples;
+		samples.reserve(window_points.size());
+		for (std::size_t p = 0; p < window_points.size(); p++)
+		{
+			samples.push_back(std::make_pair(
+				window_points[p].first / spacing - offset, window_points[p].second));
+		}
+		MeasureFitResiduals(samples, spline, result);
+		result.success = true;
+		return result;
+	}
+};
+
+}
+#endif
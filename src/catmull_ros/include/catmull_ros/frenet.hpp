@@ -0,0 +1,242 @@
+/*
+ * frenet.hpp
+ *
+ * Header file for batch transformation between Cartesian and
+ * Frenet (s, d) path coordinates relative to a Catmull-Rom spline
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_FRENET_HPP
+#define CATMULL_ROS_FRENET_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include "arc_length.hpp"
+#include "catmull.hpp"
+#include "segment_bvh.hpp"
+
+namespace catmull_ros
+{
+
+const std::size_t FRENET_GRAIN_SIZE = 1024;
+
+/**
+ * catmull_ros::FrenetPoint
+ *
+ * Path coordinates of a point: arc length s of its closest point on the
+ * spline and lateral offset d (positive to the left in the xy-plane),
+ * with the spline parameter and segment of the closest point
+ */
+struct FrenetPoint
+{
+	double s;
+	double d;
+	double t;
+	int segment;
+
+	FrenetPoint(): s(0.0), d(0.0), t(0.0), segment(-1) {}
+};
+
+/*
+Spread the lower 21 bits of x to every third bit
+*/
+inline std::uint64_t MortonSpread(std::uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffffULL;
+	x = (x | x << 16) & 0x1f0000ff0000ffULL;
+	x = (x | x << 8) & 0x100f00f00f00f00fULL;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+	x = (x | x << 2) & 0x1249249249249249ULL;
+	return x;
+}
+
+/**
+ * catmull_ros::FrenetTransformer
+ *
+ * Transforms points into (s, d) coordinates relative to a constructed
+ * spline and back.
+ *
+ * Batch transformation exploits spatial coherence: points are sorted
+ * along a Morton curve of a grid sized to the segments, so consecutive
+ * points tend to project onto the same segment. Each projection starts
+ * from the segment of the previous point, which bounds the BVH search
+ * so that most of the tree is pruned, and is refined on the Hermite
+ * cubic. Chunks of the sorted points run on TBB workers.
+ *
+ * The lateral offset is the distance from the closest point, signed by
+ * the side of the path in the xy-plane, so the inverse mapping is exact
+ * for planar points.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class FrenetTransformer
+{
+private:
+	ArcLengthTable arc;
+	SegmentBvh bvh;
+	std::vector<ControlVertex*> segments;
+	// Pending knot shift of every segment (see CatmullSpline::GetKnotOffset)
+	std::vector<double> offset;
+	double cell;
+
+	FrenetPoint Project(const Vector3& p, int hint) const
+	{
+		FrenetPoint res;
+		double t;
+		double d2;
+		const int i = bvh.Closest(p, t, d2, hint);
+		if (i < 0)
+		{
+			return res;
+		}
+		ControlVertex* cv = segments[i];
+		const Vector3 foot = cv->Hermite(t - offset[i]);
+		const Vector3 tangent = cv->dhermite(t - offset[i]);
+		const Vector3 normal = p - foot;
+		const double side = tangent.coords[0]*normal.coords[1]
+			- tangent.coords[1]*normal.coords[0];
+		res.segment = i;
+		res.t = t;
+		res.s = arc.S(i, t);
+		res.d = side < 0.0 ? -sqrt(d2) : sqrt(d2);
+		return res;
+	}
+
+	std::uint64_t MortonKey(const Vector3& p, const Vector3& origin) const
+	{
+		std::uint64_t key = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			double c = (p.coords[k] - origin.coords[k]) / cell;
+			c = std::max(0.0, std::min(2097151.0, c));
+			key |= MortonSpread(static_cast<std::uint64_t>(c)) << k;
+		}
+		return key;
+	}
+
+public:
+	/**
+	Bind to a constructed spline and build the arc length table and BVH
+	*/
+	explicit FrenetTransformer(CatmullSpline& spline):
+		arc(spline), bvh(spline), cell(1.0)
+	{
+		const int n = arc.GetNumberOfSegments();
+		segments.resize(n);
+		offset.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			segments[i] = spline.GetControlVertex(i).get();
+			offset[i] = spline.GetKnotOffset(i);
+		}
+		if (n > 0 && arc.TotalLength() > 0.0)
+		{
+			cell = arc.TotalLength() / n;
+		}
+	}
+
+	const ArcLengthTable& GetArcLengthTable() const
+	{
+		return arc;
+	}
+
+	/**
+	Frenet coordinates of a single point; hint is a segment to start from
+	*/
+	FrenetPoint ToFrenet(const Vector3& p, int hint=-1) const
+	{
+		return Project(p, hint);
+	}
+
+	/**
+	Frenet coordinates of n points (in parallel)
+	*/
+	void ToFrenet(const Vector3* points, std::size_t n, FrenetPoint* out) const
+	{
+		if (n == 0 || bvh.GetNumberOfSegments() == 0)
+		{
+			for (std::size_t i = 0; i < n; i++)
+			{
+				out[i] = FrenetPoint();
+			}
+			return;
+		}
+		BoundingBox bounds;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			bounds.Extend(points[i]);
+		}
+		std::vector<std::pair<std::uint64_t, std::size_t> > keys(n);
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n, FRENET_GRAIN_SIZE),
+			[&](const tbb::blocked_range<std::size_t>& range)
+			{
+				for (std::size_t i = range.begin(); i != range.end(); i++)
+				{
+					keys[i] = std::make_pair(MortonKey(points[i], bounds.min), i);
+				}
+			});
+		tbb::parallel_sort(keys.begin(), keys.end());
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n, FRENET_GRAIN_SIZE),
+			[&](const tbb::blocked_range<std::size_t>& range)
+			{
+				int hint = -1;
+				for (std::size_t k = range.begin(); k != range.end(); k++)
+				{
+					const std::size_t i = keys[k].second;
+					out[i] = Project(points[i], hint);
+					hint = out[i].segment;
+				}
+			});
+	}
+
+	/**
+	Cartesian point of the Frenet coordinates (s, d)
+	*/
+	Vector3 ToCartesian(double s, double d) const
+	{
+		int i;
+		double t;
+		arc.Invert(s, i, t);
+		if (i < 0)
+		{
+			return Vector3();
+		}
+		ControlVertex* cv = segments[i];
+		const Vector3 tangent = cv->dhermite(t - offset[i]);
+		const double n = sqrt(tangent.coords[0]*tangent.coords[0]
+			+ tangent.coords[1]*tangent.coords[1]);
+		Vector3 res = cv->Hermite(t - offset[i]);
+		if (n > 0.0)
+		{
+			res += Vector3(-tangent.coords[1]*d/n, tangent.coords[0]*d/n, 0.0);
+		}
+		return res;
+	}
+
+	/**
+	Cartesian points of n Frenet coordinates (in parallel)
+	*/
+	void ToCartesian(const FrenetPoint* in, std::size_t n, Vector3* out) const
+	{
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n, FRENET_GRAIN_SIZE),
+			[&](const tbb::blocked_range<std::size_t>& range)
+			{
+				for (std::size_t i = range.begin(); i != range.end(); i++)
+				{
+					out[i] = ToCartesian(in[i].s, in[i].d);
+				}
+			});
+	}
+};
+
+}
+#endif
@@ -0,0 +1,84 @@
+/*
+ * hermite_projection.hpp
+ *
+ * Header file for projecting points onto a single cubic Hermite segment
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_HERMITE_PROJECTION_HPP
+#define CATMULL_ROS_HERMITE_PROJECTION_HPP
+
+#include "vector3.hpp"
+
+namespace catmull_ros
+{
+
+const int HERMITE_PROJECTION_COARSE_SAMPLES = 8;
+const int HERMITE_PROJECTION_NEWTON_STEPS = 6;
+
+/**
+Find the local parameter dt in [0, dt_end] of the point of the segment
+a3*dt^3 + a2*dt^2 + a1*dt + a0 closest to q.
+
+A coarse uniform scan selects the basin of the global minimum, which
+is then refined with Newton iterations on (c(dt) - q) . c'(dt) = 0
+*/
+inline double ClosestHermiteParameter(const Vector3& a0, const Vector3& a1,
+	const Vector3& a2, const Vector3& a3, double dt_end, const Vector3& q)
+{
+	if (dt_end <= 0.0)
+	{
+		return 0.0;
+	}
+	double best_dt = 0.0;
+	double best_d2 = Dot(a0 - q, a0 - q);
+	const double step = dt_end / HERMITE_PROJECTION_COARSE_SAMPLES;
+	for (int i = 1; i <= HERMITE_PROJECTION_COARSE_SAMPLES; i++)
+	{
+		const double dt = step * i;
+		const Vector3 d = a3*(dt*dt*dt) + a2*(dt*dt) + a1*dt + a0 - q;
+		const double d2 = Dot(d, d);
+		if (d2 < best_d2)
+		{
+			best_d2 = d2;
+			best_dt = dt;
+		}
+	}
+	double dt = best_dt;
+	for (int i = 0; i < HERMITE_PROJECTION_NEWTON_STEPS; i++)
+	{
+		const Vector3 d = a3*(dt*dt*dt) + a2*(dt*dt) + a1*dt + a0 - q;
+		const Vector3 dc = 3.0*a3*(dt*dt) + 2.0*a2*dt + a1;
+		const Vector3 ddc = 6.0*a3*dt + 2.0*a2;
+		const double g = Dot(d, dc);
+		const double dg = Dot(dc, dc) + Dot(d, ddc);
+		if (dg <= 0.0)
+		{
+			break;
+		}
+		double next = dt - g / dg;
+		if (next < 0.0)
+		{
+			next = 0.0;
+		}
+		else if (next > dt_end)
+		{
+			next = dt_end;
+		}
+		if (fabs(next - dt) < 1e-12 * (1.0 + dt_end))
+		{
+			dt = next;
+			break;
+		}
+		dt = next;
+	}
+	const Vector3 d = a3*(dt*dt*dt) + a2*(dt*dt) + a1*dt + a0 - q;
+	if (Dot(d, d) > best_d2)
+	{
+		return best_dt;
+	}
+	return dt;
+}
+
+}
+#endif
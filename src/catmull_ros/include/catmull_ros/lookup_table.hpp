@@ -0,0 +1,347 @@
+/*
+ * lookup_table.hpp
+ *
+ * Header file for error-bounded lookup table evaluation of Catmull-Rom
+ * splines (uniform parameter resampling with O(1) queries)
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_LOOKUP_TABLE_HPP
+#define CATMULL_ROS_LOOKUP_TABLE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+const std::size_t LOOKUP_TABLE_MAX_INTERVALS = 1 << 24;
+
+/*
+Interpolation error constants on an interval of width h, see
+SplineLookupTable: max |x(x - h/2)(x - h)|/6 = h^3/(72 sqrt 3) for the
+quadratic nodes, and the worst errors of interpolating the kinks (x - k)+
+and (x - k)+^2/2 at any k (per h and h^2) for quadratic blends
+*/
+const double LOOKUP_QUADRATIC_SMOOTH = 1.0 / (72.0*sqrt(3.0));
+const double LOOKUP_QUADRATIC_KINK = 1.0 / (6.0*sqrt(3.0));
+const double LOOKUP_QUADRATIC_CURVATURE_KINK = 0.019;
+
+enum LookupBlend
+{
+	LOOKUP_LINEAR,
+	LOOKUP_QUADRATIC
+};
+
+/**
+ * catmull_ros::SplineLookupTable
+ *
+ * Resamples a constructed spline (position and velocity) on a uniform
+ * parameter grid. A query is an index computation and a linear blend of
+ * two nodes, or a quadratic blend of three nodes (the grid then also holds
+ * the interval midpoints).
+ *
+ * The grid step comes from the requested maximal position error, using
+ * the bounds of ddr of every segment (ddr is linear on a segment, so its
+ * bounds are its end values, and dddr is constant):
+ * - linear: |e| <= max|ddr| h^2/8, so h = sqrt(8 e / max|ddr|)
+ * - quadratic: |e| <= max|dddr| h^3/(72 sqrt 3) plus, for every knot in
+ *   the interval, 0.019 |jump of ddr| h^2
+ * The bounds are evaluated per component for every interval of the
+ * chosen grid (the step is reduced until they hold), and the achieved
+ * bounds of the position and the velocity are reported.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class SplineLookupTable
+{
+private:
+	/*
+	Bounds of the derivatives of one segment, per component
+	*/
+	struct SegmentBounds
+	{
+		double t0;
+		double t1;
+		// ddr at the start and the end of the segment
+		Vector3 dd0;
+		Vector3 dd1;
+		// dddr (constant on the segment) and its absolute value
+		Vector3 ddd_signed;
+		Vector3 ddd;
+	};
+
+	LookupBlend blend;
+	double t_min;
+	double t_max;
+	double step;
+	double inv_step;
+	std::size_t intervals;
+	std::vector<Vector3> positions;
+	std::vector<Vector3> velocities;
+	double position_error;
+	double velocity_error;
+
+	static double Norm(const Vector3& v)
+	{
+		return sqrt(Dot(v, v));
+	}
+
+	static Vector3 Abs(const Vector3& v)
+	{
+		return Vector3(fabs(v.coords[0]), fabs(v.coords[1]), fabs(v.coords[2]));
+	}
+
+	static Vector3 Max(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(std::max(a.coords[0], b.coords[0]), std::max(a.coords[1], b.coords[1]),
+			std::max(a.coords[2], b.coords[2]));
+	}
+
+	/*
+	Position and velocity error bounds of the blend on a grid of n
+	intervals of width h
+	*/
+	void Bound(const std::vector<SegmentBounds>& segments, std::size_t n, double h,
+		double& e_position, double& e_velocity) const
+	{
+		e_position = 0.0;
+		e_velocity = 0.0;
+		std::size_t first = 0;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			const double u0 = t_min + i*h;
+			const double u1 = u0 + h;
+			while (first + 1 < segments.size() && segments[first].t1 <= u0)
+			{
+				first++;
+			}
+			// Component-wise maxima over the overlapping segments, jumps at the knots inside
+			Vector3 dd, ddd, jump, ddd_jump;
+			for (std::size_t k = first; k < segments.size() && (k == first || segments[k].t0 < u1); k++)
+			{
+				dd = Max(dd, Max(Abs(segments[k].dd0), Abs(segments[k].dd1)));
+				ddd = Max(ddd, segments[k].ddd);
+				if (k > first)
+				{
+					jump += Abs(segments[k].dd0 - segments[k - 1].dd1);
+					ddd_jump += Abs(segments[k].ddd_signed - segments[k - 1].ddd_signed);
+				}
+			}
+			double ep, ev;
+			if (blend == LOOKUP_LINEAR)
+			{
+				ep = Norm(dd)*h*h/8.0;
+				ev = Norm(ddd)*h*h/8.0 + Norm(jump)*h/4.0;
+			}
+			else
+			{
+				ep = LOOKUP_QUADRATIC_SMOOTH*Norm(ddd)*h*h*h
+					+ LOOKUP_QUADRATIC_CURVATURE_KINK*Norm(jump)*h*h;
+				// The velocity is quadratic on a segment, only the kinks contribute
+				ev = LOOKUP_QUADRATIC_KINK*Norm(jump)*h
+					+ LOOKUP_QUADRATIC_CURVATURE_KINK*Norm(ddd_jump)*h*h;
+			}
+			e_position = std::max(e_position, ep);
+			e_velocity = std::max(e_velocity, ev);
+		}
+	}
+
+	/*
+	Index of the interval of t and the local coordinate in it
+	*/
+	std::size_t Locate(double t, double& s) const
+	{
+		const double u = std::max(0.0, (t - t_min)*inv_step);
+		std::size_t i = static_cast<std::size_t>(u);
+		if (i >= intervals)
+		{
+			i = intervals - 1;
+		}
+		s = std::min(1.0, u - i);
+		return i;
+	}
+
+	Vector3 Blend(const std::vector<Vector3>& nodes, std::size_t i, double s) const
+	{
+		if (blend == LOOKUP_LINEAR)
+		{
+			const Vector3& a = nodes[i];
+			const Vector3& b = nodes[i + 1];
+			return Vector3(a.coords[0] + s*(b.coords[0] - a.coords[0]),
+				a.coords[1] + s*(b.coords[1] - a.coords[1]),
+				a.coords[2] + s*(b.coords[2] - a.coords[2]));
+		}
+		// Lagrange basis of the nodes 0, 1/2, 1
+		const Vector3& a = nodes[2*i];
+		const Vector3& m = nodes[2*i + 1];
+		const Vector3& b = nodes[2*i + 2];
+		const double la = 2.0*(s - 0.5)*(s - 1.0);
+		const double lm = -4.0*s*(s - 1.0);
+		const double lb = 2.0*s*(s - 0.5);
+		return Vector3(la*a.coords[0] + lm*m.coords[0] + lb*b.coords[0],
+			la*a.coords[1] + lm*m.coords[1] + lb*b.coords[1],
+			la*a.coords[2] + lm*m.coords[2] + lb*b.coords[2]);
+	}
+
+public:
+	/**
+	Build the table of a constructed spline for the maximal position error
+	(at most max_intervals intervals: if that is not enough, the reported
+	error bound is larger than max_error)
+	*/
+	SplineLookupTable(CatmullSpline& spline, double max_error, LookupBlend blend=LOOKUP_LINEAR,
+		std::size_t max_intervals=LOOKUP_TABLE_MAX_INTERVALS):
+		blend(blend), t_min(0.0), t_max(0.0), step(0.0), inv_step(0.0), intervals(0),
+		position_error(0.0), velocity_error(0.0)
+	{
+		const int n = spline.GetNumberOfSegments();
+		if (n == 0)
+		{
+			return;
+		}
+		std::vector<SegmentBounds> segments(n);
+		std::vector<ControlVertex*> vertices(n);
+		std::vector<double> offset(n);
+		for (int i = 0; i < n; i++)
+		{
+			vertices[i] = spline.GetControlVertex(i).get();
+			offset[i] = spline.GetKnotOffset(i);
+			SegmentBounds& b = segments[i];
+			b.t0 = spline.GetSegmentStartT(i);
+			b.t1 = spline.GetSegmentEndT(i);
+			b.dd0 = vertices[i]->ddhermite(b.t0 - offset[i]);
+			b.dd1 = vertices[i]->ddhermite(b.t1 - offset[i]);
+			b.ddd_signed = b.t1 > b.t0 ? (1.0 / (b.t1 - b.t0))*(b.dd1 - b.dd0) : Vector3();
+			b.ddd = Abs(b.ddd_signed);
+		}
+		t_min = segments.front().t0;
+		t_max = segments.back().t1;
+		const double range = t_max - t_min;
+		// Initial step from the global bounds, without the kinks
+		Vector3 dd, ddd;
+		for (int i = 0; i < n; i++)
+		{
+			dd = Max(dd, Max(Abs(segments[i].dd0), Abs(segments[i].dd1)));
+			ddd = Max(ddd, segments[i].ddd);
+		}
+		double h = range;
+		if (blend == LOOKUP_LINEAR && Norm(dd) > 0.0)
+		{
+			h = std::min(h, sqrt(8.0*max_error / Norm(dd)));
+		}
+		else if (blend == LOOKUP_QUADRATIC && Norm(ddd) > 0.0)
+		{
+			h = std::min(h, cbrt(max_error / (LOOKUP_QUADRATIC_SMOOTH*Norm(ddd))));
+		}
+		max_intervals = std::max<std::size_t>(1, max_intervals);
+		std::size_t count = 1;
+		while (range > 0.0)
+		{
+			count = static_cast<std::size_t>(std::max(1.0,
+				std::min(static_cast<double>(max_intervals), ceil(range / h))));
+			Bound(segments, count, range / count, position_error, velocity_error);
+			if (position_error <= max_error || count == max_intervals)
+			{
+				break;
+			}
+			// Shrink by the missing factor (at least by 10 percent)
+			const double order = blend == LOOKUP_LINEAR ? 0.5 : 1.0/3.0;
+			h = (range / count)*std::min(0.9, pow(max_error / position_error, order));
+		}
+		intervals = count;
+		step = range / intervals;
+		inv_step = step > 0.0 ? 1.0 / step : 0.0;
+		const std::size_t nodes = blend == LOOKUP_LINEAR ? intervals + 1 : 2*intervals + 1;
+		const double node_step = blend == LOOKUP_LINEAR ? step : 0.5*step;
+		positions.resize(nodes);
+		velocities.resize(nodes);
+		int segment = 0;
+		for (std::size_t i = 0; i < nodes; i++)
+		{
+			const double t = i + 1 == nodes ? t_max : t_min + i*node_step;
+			while (segment + 1 < n && t >= segments[segment + 1].t0)
+			{
+				segment++;
+			}
+			positions[i] = vertices[segment]->Hermite(t - offset[segment]);
+			velocities[i] = vertices[segment]->dhermite(t - offset[segment]);
+		}
+	}
+
+	/**
+	Position at t (clamped to the parameter range)
+	*/
+	Vector3 r(double t) const
+	{
+		double s;
+		const std::size_t i = Locate(t, s);
+		return Blend(positions, i, s);
+	}
+
+	/**
+	Velocity at t (clamped to the parameter range)
+	*/
+	Vector3 dr(double t) const
+	{
+		double s;
+		const std::size_t i = Locate(t, s);
+		return Blend(velocities, i, s);
+	}
+
+	void Evaluate(double t, Vector3& position, Vector3& velocity) const
+	{
+		double s;
+		const std::size_t i = Locate(t, s);
+		position = Blend(positions, i, s);
+		velocity = Blend(velocities, i, s);
+	}
+
+	/**
+	Achieved bound of the position error
+	*/
+	double GetErrorBound() const
+	{
+		return position_error;
+	}
+
+	/**
+	Achieved bound of the velocity error
+	*/
+	double GetVelocityErrorBound() const
+	{
+		return velocity_error;
+	}
+
+	double GetStep() const
+	{
+		return step;
+	}
+
+	std::size_t GetNumberOfIntervals() const
+	{
+		return intervals;
+	}
+
+	std::size_t GetNumberOfNodes() const
+	{
+		return positions.size();
+	}
+
+	double GetMinT() const
+	{
+		return t_min;
+	}
+
+	double GetMaxT() const
+	{
+		return t_max;
+	}
+};
+
+}
+#endif
@@ -0,0 +1,128 @@
+/*
+ * lru_cache.hpp
+ *
+ * Header file for a bounded, thread-safe least recently used cache
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_LRU_CACHE_HPP
+#define CATMULL_ROS_LRU_CACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace catmull_ros
+{
+
+/**
+ * catmull_ros::LruCache
+ *
+ * Holds at most capacity values, evicting the least recently used one.
+ * Values are handed out as shared pointers, so an evicted value stays
+ * valid for the callers still using it. All operations are guarded by a
+ * mutex, the cache may be filled from a loader thread.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+template <typename Key, typename Value>
+class LruCache
+{
+private:
+	typedef std::pair<Key, std::shared_ptr<const Value> > Entry;
+	std::size_t capacity;
+	// Most recently used first
+	std::list<Entry> entries;
+	std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+	mutable std::mutex mutex;
+	std::size_t hits;
+	std::size_t misses;
+public:
+	explicit LruCache(std::size_t capacity): capacity(capacity), hits(0), misses(0)
+	{
+	}
+
+	/**
+	The value of key (marked as most recently used), nullptr if missing
+	*/
+	std::shared_ptr<const Value> Get(const Key& key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		typename std::unordered_map<Key, typename std::list<Entry>::iterator>::iterator it =
+			index.find(key);
+		if (it == index.end())
+		{
+			misses++;
+			return std::shared_ptr<const Value>();
+		}
+		hits++;
+		entries.splice(entries.begin(), entries, it->second);
+		return it->second->second;
+	}
+
+	bool Contains(const Key& key) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return index.find(key) != index.end();
+	}
+
+	/**
+	Insert or replace the value of key, evicting the least recently used
+	values above the capacity
+	*/
+	void Put(const Key& key, std::shared_ptr<const Value> value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		typename std::unordered_map<Key, typename std::list<Entry>::iterator>::iterator it =
+			index.find(key);
+		if (it != index.end())
+		{
+			it->second->second = value;
+			entries.splice(entries.begin(), entries, it->second);
+			return;
+		}
+		entries.push_front(Entry(key, value));
+		index[key] = entries.begin();
+		while (entries.size() > capacity)
+		{
+			index.erase(entries.back().first);
+			entries.pop_back();
+		}
+	}
+
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.clear();
+		index.clear();
+	}
+
+	std::size_t Size() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.size();
+	}
+
+	std::size_t Capacity() const
+	{
+		return capacity;
+	}
+
+	std::size_t Hits() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return hits;
+	}
+
+	std::size_t Misses() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return misses;
+	}
+};
+
+}
+#endif
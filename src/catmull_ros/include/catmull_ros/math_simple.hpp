@@ -9,6 +9,7 @@
 #ifndef MATH_SIMPLE_HPP
 #define MATH_SIMPLE_HPP
 
+#include <cmath>
 
 namespace ros_math_simple {
     inline double clamp(double val, double min, double max)
@@ -16,6 +17,32 @@ namespace ros_math_simple {
         const double t = val < min ? min: val;
         return t > max ? max : t;
     }
+
+    /**
+     * Linear interpolation between a (t = 0) and b (t = 1)
+     */
+    inline double lerp(double a, double b, double t)
+    {
+        return a + (b - a) * t;
+    }
+
+    /**
+     * Hermite smoothstep of x between edge0 and edge1
+     */
+    inline double smoothstep(double edge0, double edge1, double x)
+    {
+        const double t = clamp((x - edge0) / (edge1 - edge0), 0.0, 1.0);
+        return (t * t) * (3.0 - 2.0 * t);
+    }
+
+    /**
+     * Wrap an angle into [-pi, pi)
+     */
+    inline double wrap_angle(double angle)
+    {
+        const double two_pi = 2.0 * M_PI;
+        return angle - two_pi * floor((angle + M_PI) / two_pi);
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,311 @@
+/*
+ * math_simple_batch.hpp
+ *
+ * Header file for array (batch) versions of the simple math functions,
+ * vectorized with AVX2 when the CPU supports it (runtime dispatch)
+ * and falling back to the scalar functions otherwise.
+ *
+ * The vectorized kernels perform the same IEEE operations in the same
+ * order as the scalar functions, so the results are bit-identical
+ * (as long as the scalar code is not compiled with FMA contraction).
+ * In-place operation (out == in) is allowed.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef MATH_SIMPLE_BATCH_HPP
+#define MATH_SIMPLE_BATCH_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#include "math_simple.hpp"
+#include "vector3.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ROS_MATH_SIMPLE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace ros_math_simple {
+
+    /**
+     * True if the vectorized kernels are used on this CPU
+     */
+    inline bool has_simd()
+    {
+#ifdef ROS_MATH_SIMPLE_AVX2
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Normalize a single vector (zero vectors are left untouched)
+     */
+    inline void normalize_scalar(catmull_ros::Vector3& v)
+    {
+        const double sq = v.coords[0] * v.coords[0] + v.coords[1] * v.coords[1]
+            + v.coords[2] * v.coords[2];
+        if (sq > 0.0)
+        {
+            const double inv = 1.0 / sqrt(sq);
+            v.coords[0] = v.coords[0] * inv;
+            v.coords[1] = v.coords[1] * inv;
+            v.coords[2] = v.coords[2] * inv;
+        }
+    }
+
+#ifdef ROS_MATH_SIMPLE_AVX2
+    /*
+     * AVX2 kernels: the tails shorter than a register use the scalar functions
+     */
+    __attribute__((target("avx2")))
+    inline void clamp_array_avx2(const double* in, double* out, std::size_t n,
+        double min, double max)
+    {
+        const __m256d vmin = _mm256_set1_pd(min);
+        const __m256d vmax = _mm256_set1_pd(max);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            // max_pd(a, b) = a > b ? a : b, min_pd(a, b) = a < b ? a : b
+            // which matches clamp for NaN and signed zeros
+            const __m256d t = _mm256_max_pd(vmin, _mm256_loadu_pd(in + i));
+            _mm256_storeu_pd(out + i, _mm256_min_pd(vmax, t));
+        }
+        for (; i < n; i++)
+        {
+            out[i] = clamp(in[i], min, max);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    inline void lerp_array_avx2(const double* a, const double* b, double t,
+        double* out, std::size_t n)
+    {
+        const __m256d vt = _mm256_set1_pd(t);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256d va = _mm256_loadu_pd(a + i);
+            const __m256d d = _mm256_sub_pd(_mm256_loadu_pd(b + i), va);
+            _mm256_storeu_pd(out + i, _mm256_add_pd(va, _mm256_mul_pd(d, vt)));
+        }
+        for (; i < n; i++)
+        {
+            out[i] = lerp(a[i], b[i], t);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    inline void smoothstep_array_avx2(double edge0, double edge1,
+        const double* x, double* out, std::size_t n)
+    {
+        const __m256d ve0 = _mm256_set1_pd(edge0);
+        const __m256d vw = _mm256_set1_pd(edge1 - edge0);
+        const __m256d zero = _mm256_set1_pd(0.0);
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d two = _mm256_set1_pd(2.0);
+        const __m256d three = _mm256_set1_pd(3.0);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m256d t = _mm256_div_pd(
+                _mm256_sub_pd(_mm256_loadu_pd(x + i), ve0), vw);
+            t = _mm256_min_pd(one, _mm256_max_pd(zero, t));
+            const __m256d s = _mm256_sub_pd(three, _mm256_mul_pd(two, t));
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_mul_pd(t, t), s));
+        }
+        for (; i < n; i++)
+        {
+            out[i] = smoothstep(edge0, edge1, x[i]);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    inline void wrap_angle_array_avx2(const double* in, double* out, std::size_t n)
+    {
+        const __m256d pi = _mm256_set1_pd(M_PI);
+        const __m256d two_pi = _mm256_set1_pd(2.0 * M_PI);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256d a = _mm256_loadu_pd(in + i);
+            const __m256d k = _mm256_floor_pd(
+                _mm256_div_pd(_mm256_add_pd(a, pi), two_pi));
+            _mm256_storeu_pd(out + i, _mm256_sub_pd(a, _mm256_mul_pd(two_pi, k)));
+        }
+        for (; i < n; i++)
+        {
+            out[i] = wrap_angle(in[i]);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    inline void rsqrt_array_avx2(const double* in, double* out, std::size_t n)
+    {
+        const __m256d one = _mm256_set1_pd(1.0);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256d r = _mm256_sqrt_pd(_mm256_loadu_pd(in + i));
+            _mm256_storeu_pd(out + i, _mm256_div_pd(one, r));
+        }
+        for (; i < n; i++)
+        {
+            out[i] = 1.0 / sqrt(in[i]);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    inline void normalize_array_avx2(catmull_ros::Vector3* v, std::size_t n)
+    {
+        // The squared norms of four vectors are packed into one register
+        // for the expensive square root and division
+        const __m256d one = _mm256_set1_pd(1.0);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            double sq[4];
+            for (int k = 0; k < 4; k++)
+            {
+                const double* c = v[i + k].coords;
+                sq[k] = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+            }
+            double inv[4];
+            _mm256_storeu_pd(inv, _mm256_div_pd(one,
+                _mm256_sqrt_pd(_mm256_loadu_pd(sq))));
+            for (int k = 0; k < 4; k++)
+            {
+                // Zero vectors are left untouched
+                if (sq[k] > 0.0)
+                {
+                    double* c = v[i + k].coords;
+                    c[0] = c[0] * inv[k];
+                    c[1] = c[1] * inv[k];
+                    c[2] = c[2] * inv[k];
+                }
+            }
+        }
+        for (; i < n; i++)
+        {
+            normalize_scalar(v[i]);
+        }
+    }
+#endif
+
+    /**
+     * out[i] = clamp(in[i], min, max)
+     */
+    inline void clamp_array(const double* in, double* out, std::size_t n,
+        double min, double max)
+    {
+#ifdef ROS_MATH_SIMPLE_AVX2
+        if (has_simd())
+        {
+            clamp_array_avx2(in, out, n, min, max);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+        {
+            out[i] = clamp(in[i], min, max);
+        }
+    }
+
+    /**
+     * out[i] = lerp(a[i], b[i], t), blending two profiles
+     */
+    inline void lerp_array(const double* a, const double* b, double t,
+        double* out, std::size_t n)
+    {
+#ifdef ROS_MATH_SIMPLE_AVX2
+        if (has_simd())
+        {
+            lerp_array_avx2(a, b, t, out, n);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+        {
+            out[i] = lerp(a[i], b[i], t);
+        }
+    }
+
+    /**
+     * out[i] = smoothstep(edge0, edge1, x[i])
+     */
+    inline void smoothstep_array(double edge0, double edge1, const double* x,
+        double* out, std::size_t n)
+    {
+#ifdef ROS_MATH_SIMPLE_AVX2
+        if (has_simd())
+        {
+            smoothstep_array_avx2(edge0, edge1, x, out, n);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+        {
+            out[i] = smoothstep(edge0, edge1, x[i]);
+        }
+    }
+
+    /**
+     * out[i] = wrap_angle(in[i])
+     */
+    inline void wrap_angle_array(const double* in, double* out, std::size_t n)
+    {
+#ifdef ROS_MATH_SIMPLE_AVX2
+        if (has_simd())
+        {
+            wrap_angle_array_avx2(in, out, n);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+        {
+            out[i] = wrap_angle(in[i]);
+        }
+    }
+
+    /**
+     * out[i] = 1 / sqrt(in[i])
+     */
+    inline void rsqrt_array(const double* in, double* out, std::size_t n)
+    {
+#ifdef ROS_MATH_SIMPLE_AVX2
+        if (has_simd())
+        {
+            rsqrt_array_avx2(in, out, n);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+        {
+            out[i] = 1.0 / sqrt(in[i]);
+        }
+    }
+
+    /**
+     * Normalize the vectors in place (zero vectors are left untouched)
+     */
+    inline void normalize_array(catmull_ros::Vector3* v, std::size_t n)
+    {
+#ifdef ROS_MATH_SIMPLE_AVX2
+        if (has_simd())
+        {
+            normalize_array_avx2(v, n);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+        {
+            normalize_scalar(v[i]);
+        }
+    }
+}
+
+#endif
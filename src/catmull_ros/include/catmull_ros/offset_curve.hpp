@@ -0,0 +1,261 @@
+/*
+ * offset_curve.hpp
+ *
+ * Header file for generating lateral offset curves (lane boundaries,
+ * corridors) of a Catmull-Rom spline
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_OFFSET_CURVE_HPP
+#define CATMULL_ROS_OFFSET_CURVE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "arc_length.hpp"
+#include "catmull.hpp"
+#include "decimation.hpp"
+
+namespace catmull_ros
+{
+
+/*
+Intersection of the 2D segments p0-p1 and q0-q1 (xy-plane), the point is
+interpolated on the first segment
+*/
+inline bool IntersectSegments2D(const Vector3& p0, const Vector3& p1,
+	const Vector3& q0, const Vector3& q1, Vector3& res)
+{
+	const double rx = p1.coords[0] - p0.coords[0];
+	const double ry = p1.coords[1] - p0.coords[1];
+	const double sx = q1.coords[0] - q0.coords[0];
+	const double sy = q1.coords[1] - q0.coords[1];
+	const double denom = rx*sy - ry*sx;
+	if (denom == 0.0)
+	{
+		return false;
+	}
+	const double qpx = q0.coords[0] - p0.coords[0];
+	const double qpy = q0.coords[1] - p0.coords[1];
+	const double u = (qpx*sy - qpy*sx) / denom;
+	const double v = (qpx*ry - qpy*rx) / denom;
+	if (u < 0.0 || u > 1.0 || v < 0.0 || v > 1.0)
+	{
+		return false;
+	}
+	res = p0 + u*(p1 - p0);
+	return true;
+}
+
+/**
+ * catmull_ros::OffsetCurveGenerator
+ *
+ * Samples the centreline of a constructed spline once (position, unit
+ * normal in the xy-plane and signed curvature, uniformly in arc length)
+ * and emits lateral offsets p + d*n for any number of distances d
+ * (positive to the left) in one pass over the structure-of-arrays
+ * samples, which the compiler vectorizes.
+ *
+ * Where an offset on the concave side exceeds the radius of curvature
+ * (1 - d*k <= 0) the raw offset folds over into a swallowtail loop. Those
+ * samples are dropped and the polyline is joined at the self-intersection
+ * of its neighbouring pieces, which trims the loop. Only such local
+ * folds are removed, offsets of a path that comes back close to itself
+ * can still cross each other.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class OffsetCurveGenerator
+{
+private:
+	std::vector<double> px;
+	std::vector<double> py;
+	std::vector<double> pz;
+	std::vector<double> nx;
+	std::vector<double> ny;
+	std::vector<double> curvature;
+	// Window of samples searched for the self-intersection around a fold
+	int trim_window;
+
+	/*
+	Remove the folded runs of a raw offset polyline: a run is cut at the
+	first crossing of the pieces around it, or simply dropped if they do
+	not cross within the window
+	*/
+	void Trim(double d, const std::vector<Vector3>& raw, std::vector<Vector3>& out) const
+	{
+		const int n = static_cast<int>(raw.size());
+		out.clear();
+		int i = 0;
+		while (i < n)
+		{
+			if (1.0 - d*curvature[i] > 0.0)
+			{
+				out.push_back(raw[i]);
+				i++;
+				continue;
+			}
+			// Folded run [i, j)
+			int j = i;
+			while (j < n && 1.0 - d*curvature[j] <= 0.0)
+			{
+				j++;
+			}
+			bool joined = false;
+			const int before_first = std::max(1, static_cast<int>(out.size()) - trim_window);
+			for (int a = static_cast<int>(out.size()) - 1; a >= before_first && !joined; a--)
+			{
+				for (int b = j; b < std::min(n - 1, j + trim_window) && !joined; b++)
+				{
+					Vector3 x;
+					if (IntersectSegments2D(out[a - 1], out[a], raw[b], raw[b + 1], x))
+					{
+						out.resize(a);
+						out.push_back(x);
+						i = b + 1;
+						joined = true;
+					}
+				}
+			}
+			if (!joined)
+			{
+				i = j;
+			}
+		}
+	}
+
+public:
+	/**
+	Sample the spline with the given arc length step
+	*/
+	OffsetCurveGenerator(CatmullSpline& spline, double step, int trim_window=32):
+		trim_window(trim_window)
+	{
+		ArcLengthTable arc(spline);
+		const double length = arc.TotalLength();
+		if (arc.GetNumberOfSegments() == 0 || step <= 0.0)
+		{
+			return;
+		}
+		const int n = static_cast<int>(ceil(length / step)) + 1;
+		px.resize(n);
+		py.resize(n);
+		pz.resize(n);
+		nx.resize(n);
+		ny.resize(n);
+		curvature.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			int segment;
+			double t;
+			arc.Invert(std::min(length, i*step), segment, t);
+			std::shared_ptr<ControlVertex> cv = spline.GetControlVertex(segment);
+			const double local = t - spline.GetKnotOffset(segment);
+			const Vector3 p = cv->Hermite(local);
+			const Vector3 v = cv->dhermite(local);
+			const Vector3 a = cv->ddhermite(local);
+			const double speed2 = v.coords[0]*v.coords[0] + v.coords[1]*v.coords[1];
+			const double speed = sqrt(speed2);
+			px[i] = p.coords[0];
+			py[i] = p.coords[1];
+			pz[i] = p.coords[2];
+			if (speed > 0.0)
+			{
+				nx[i] = -v.coords[1] / speed;
+				ny[i] = v.coords[0] / speed;
+				curvature[i] = (v.coords[0]*a.coords[1] - v.coords[1]*a.coords[0])
+					/ (speed2*speed);
+			}
+			else
+			{
+				nx[i] = 0.0;
+				ny[i] = 0.0;
+				curvature[i] = 0.0;
+			}
+		}
+	}
+
+	int GetNumberOfSamples() const
+	{
+		return static_cast<int>(px.size());
+	}
+
+	/**
+	Signed curvature of the i-th centreline sample (positive turning left)
+	*/
+	double GetCurvature(int i) const
+	{
+		return curvature[i];
+	}
+
+	/**
+	Raw offsets of every sample for every distance, without trimming:
+	out[k*samples + i] is the i-th sample of the k-th distance
+	*/
+	void OffsetRaw(const double* distances, std::size_t count, Vector3* out) const
+	{
+		const std::size_t n = px.size();
+		for (std::size_t k = 0; k < count; k++)
+		{
+			const double d = distances[k];
+			Vector3* row = out + k*n;
+			for (std::size_t i = 0; i < n; i++)
+			{
+				row[i].coords[0] = px[i] + d*nx[i];
+				row[i].coords[1] = py[i] + d*ny[i];
+				row[i].coords[2] = pz[i];
+			}
+		}
+	}
+
+	/**
+	Offset polylines for every distance, with the folds trimmed
+	*/
+	void Offset(const std::vector<double>& distances,
+		std::vector<std::vector<Vector3> >& polylines) const
+	{
+		const std::size_t n = px.size();
+		std::vector<Vector3> raw(n*distances.size());
+		OffsetRaw(distances.data(), distances.size(), raw.data());
+		polylines.resize(distances.size());
+		std::vector<Vector3> row(n);
+		for (std::size_t k = 0; k < distances.size(); k++)
+		{
+			std::copy(raw.begin() + k*n, raw.begin() + (k + 1)*n, row.begin());
+			Trim(distances[k], row, polylines[k]);
+		}
+	}
+
+	/**
+	Offset curve for the distance d refitted as a spline: the trimmed
+	polyline is interpolated and decimated within the tolerance.
+	Returns the achieved decimation result
+	*/
+	DecimationResult OffsetSpline(double d, double tolerance, CatmullSpline& spline) const
+	{
+		std::vector<double> distances(1, d);
+		std::vector<std::vector<Vector3> > polylines;
+		Offset(distances, polylines);
+		CatmullSpline dense;
+		for (std::size_t i = 0; i < polylines[0].size(); i++)
+		{
+			// Repeated points would give zero-length segments
+			if (i == 0 || Distance(polylines[0][i], polylines[0][i - 1]) > 0.0)
+			{
+				dense.AddControlVertex(polylines[0][i]);
+			}
+		}
+		if (dense.GetNumberOfControlVertices() == 0)
+		{
+			return DecimationResult();
+		}
+		dense.Construct();
+		SplineDecimator decimator(dense, tolerance);
+		return decimator.Decimate(spline);
+	}
+};
+
+}
+#endif
@@ -0,0 +1,325 @@
+/*
+ * pose_spline.hpp
+ *
+ * Header file for an orientation-aware (SE(3)) pose spline built
+ * on the knots of a Catmull-Rom position spline
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_POSE_SPLINE_HPP
+#define CATMULL_ROS_POSE_SPLINE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "catmull.hpp"
+#include "quaternion.hpp"
+
+namespace catmull_ros
+{
+
+const double POSE_SPLINE_SERIES_ANGLE = 1e-2;
+
+/**
+ * catmull_ros::PoseSample
+ *
+ * Pose and its derivatives at a given parameter.
+ * The angular velocity and acceleration are expressed in the body frame,
+ * orientation.Rotate() transforms them into the world frame.
+ */
+struct PoseSample
+{
+	Vector3 position;
+	Vector3 velocity;
+	Vector3 acceleration;
+	Quaternion orientation;
+	Vector3 angular_velocity;
+	Vector3 angular_acceleration;
+};
+
+/*
+Coefficients of the right Jacobian of SO(3), J = I - a [phi]x + b [phi]x^2,
+and of their derivatives divided by the angle
+*/
+inline void RightJacobianCoefficients(double theta, double& a, double& b,
+	double& da, double& db)
+{
+	const double t2 = theta*theta;
+	if (theta < POSE_SPLINE_SERIES_ANGLE)
+	{
+		a = 0.5 - t2/24.0 + t2*t2/720.0;
+		b = 1.0/6.0 - t2/120.0 + t2*t2/5040.0;
+		da = -1.0/12.0 + t2/180.0;
+		db = -1.0/60.0 + t2/1260.0;
+		return;
+	}
+	const double s = sin(theta);
+	const double c = cos(theta);
+	a = (1.0 - c) / t2;
+	b = (theta - s) / (t2*theta);
+	da = (theta*s - 2.0*(1.0 - c)) / (t2*t2);
+	db = (1.0 - c) / (t2*t2) - 3.0*(theta - s) / (t2*t2*theta);
+}
+
+/*
+Inverse right Jacobian of SO(3) applied to v
+*/
+inline Vector3 InverseRightJacobian(const Vector3& phi, const Vector3& v)
+{
+	const double theta = sqrt(Dot(phi, phi));
+	double c;
+	if (theta < POSE_SPLINE_SERIES_ANGLE)
+	{
+		c = 1.0/12.0 + theta*theta/720.0;
+	}
+	else
+	{
+		c = 1.0/(theta*theta) - (1.0 + cos(theta)) / (2.0*theta*sin(theta));
+	}
+	const Vector3 pv = Cross(phi, v);
+	return v + 0.5*pv + c*Cross(phi, pv);
+}
+
+/**
+ * catmull_ros::PoseSpline
+ *
+ * Pairs a constructed CatmullSpline (positions) with one orientation per
+ * control vertex, interpolated on the same knots.
+ *
+ * On segment i the orientation is q(t) = q_i exp(phi(t)), where phi is a
+ * cubic Hermite curve in the tangent space of q_i: it starts at zero,
+ * ends at log(q_i^-1 q_(i+1)), and its end tangents are Catmull-Rom
+ * averages of the neighbouring body rates. The end tangent is mapped
+ * through the inverse right Jacobian, so the angular velocity is
+ * continuous across the knots.
+ *
+ * Construct() precomputes everything per segment, evaluation neither
+ * allocates nor searches when the parameters are increasing, which is
+ * what the batched Evaluate() exploits.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class PoseSpline
+{
+private:
+	CatmullSpline& positions;
+	std::vector<Quaternion> orientations;
+	std::vector<ControlVertex*> segments;
+	// Segment i spans [knots[i], knots[i+1])
+	std::vector<double> knots;
+	// Pending knot shift of every segment (see CatmullSpline::GetKnotOffset)
+	std::vector<double> offset;
+	// Per segment: log(q_i^-1 q_(i+1)), start and end tangents of phi
+	std::vector<Vector3> delta;
+	std::vector<Vector3> tangent_start;
+	std::vector<Vector3> tangent_end;
+	bool closed;
+
+	int FindSegment(double& t, int hint) const
+	{
+		const int n = static_cast<int>(segments.size());
+		if (closed)
+		{
+			const double period = knots[n] - knots[0];
+			t = knots[0] + fmod(fmod(t - knots[0], period) + period, period);
+		}
+		else
+		{
+			t = std::max(knots[0], std::min(knots[n], t));
+		}
+		if (hint >= 0 && hint < n && knots[hint] <= t)
+		{
+			if (t < knots[hint + 1] || (hint == n - 1 && t <= knots[n]))
+			{
+				return hint;
+			}
+			if (hint + 1 < n && t < knots[hint + 2])
+			{
+				return hint + 1;
+			}
+		}
+		const int i = static_cast<int>(
+			std::upper_bound(knots.begin(), knots.end(), t) - knots.begin()) - 1;
+		return std::max(0, std::min(n - 1, i));
+	}
+
+	void EvaluateSegment(int i, double t, PoseSample& out) const
+	{
+		ControlVertex* cv = segments[i];
+		out.position = cv->Hermite(t - offset[i]);
+		out.velocity = cv->dhermite(t - offset[i]);
+		out.acceleration = cv->ddhermite(t - offset[i]);
+
+		const double h = knots[i + 1] - knots[i];
+		const double u = (t - knots[i]) / h;
+		const double u2 = u*u;
+		const double u3 = u2*u;
+		// Hermite basis h10, h01, h11 and their derivatives in u
+		const double b10 = u3 - 2.0*u2 + u;
+		const double b01 = -2.0*u3 + 3.0*u2;
+		const double b11 = u3 - u2;
+		const double d10 = 3.0*u2 - 4.0*u + 1.0;
+		const double d01 = -6.0*u2 + 6.0*u;
+		const double d11 = 3.0*u2 - 2.0*u;
+		const double dd10 = 6.0*u - 4.0;
+		const double dd01 = -12.0*u + 6.0;
+		const double dd11 = 6.0*u - 2.0;
+		const Vector3& ws = tangent_start[i];
+		const Vector3& we = tangent_end[i];
+		const Vector3& d = delta[i];
+		const Vector3 phi = (b10*h)*ws + b01*d + (b11*h)*we;
+		const Vector3 dphi = d10*ws + (d01/h)*d + d11*we;
+		const Vector3 ddphi = (dd10/h)*ws + (dd01/(h*h))*d + (dd11/h)*we;
+
+		out.orientation = orientations[i] * Quaternion::Exp(phi);
+
+		const double theta = sqrt(Dot(phi, phi));
+		double a, b, da, db;
+		RightJacobianCoefficients(theta, a, b, da, db);
+		const Vector3 p_dp = Cross(phi, dphi);
+		const Vector3 p_ddp = Cross(phi, ddphi);
+		out.angular_velocity = dphi - a*p_dp + b*Cross(phi, p_dp);
+		const double rate = Dot(phi, dphi);
+		out.angular_acceleration = ddphi - a*p_ddp + b*Cross(phi, p_ddp)
+			- (da*rate)*p_dp + (db*rate)*Cross(phi, p_dp)
+			+ b*Cross(dphi, p_dp);
+	}
+
+public:
+	/**
+	Bind the pose spline to a position spline, which shall be constructed
+	before Construct() of the pose spline is called
+	*/
+	explicit PoseSpline(CatmullSpline& positions): positions(positions), closed(false)
+	{
+	}
+
+	/**
+	Add the orientation of the next control vertex
+	*/
+	void AddOrientation(const Quaternion& q)
+	{
+		orientations.push_back(q.Normalized());
+	}
+
+	/**
+	Precompute the orientation segments on the knots of the position spline.
+	Returns false if there is not one orientation per control vertex
+	*/
+	bool Construct()
+	{
+		const int n = positions.GetNumberOfControlVertices();
+		const int m = positions.GetNumberOfSegments();
+		if (n != static_cast<int>(orientations.size()) || m < 1)
+		{
+			return false;
+		}
+		closed = positions.IsClosed();
+		segments.resize(m);
+		knots.resize(m + 1);
+		offset.resize(m);
+		delta.resize(m);
+		tangent_start.resize(m);
+		tangent_end.resize(m);
+		for (int i = 0; i < m; i++)
+		{
+			segments[i] = positions.GetControlVertex(i).get();
+			knots[i] = positions.GetSegmentStartT(i);
+			offset[i] = positions.GetKnotOffset(i);
+			const Quaternion& q0 = orientations[i];
+			Quaternion q1 = orientations[(i + 1) % n];
+			// Take the shorter way around
+			if (q0.w*q1.w + q0.x*q1.x + q0.y*q1.y + q0.z*q1.z < 0.0)
+			{
+				q1 = Quaternion(-q1.w, -q1.x, -q1.y, -q1.z);
+				orientations[(i + 1) % n] = q1;
+			}
+			delta[i] = (q0.Conjugate() * q1).Log();
+		}
+		knots[m] = positions.GetSegmentEndT(m - 1);
+		// Body rates at the vertices
+		std::vector<Vector3> rates(n);
+		for (int v = 0; v < n; v++)
+		{
+			const bool has_prev = closed || v > 0;
+			const bool has_next = closed || v < m;
+			const int prev = (v - 1 + m) % m;
+			const int next = v % m;
+			Vector3 rate;
+			int count = 0;
+			if (has_prev)
+			{
+				rate += delta[prev] / (knots[prev + 1] - knots[prev]);
+				count++;
+			}
+			if (has_next)
+			{
+				rate += delta[next] / (knots[next + 1] - knots[next]);
+				count++;
+			}
+			rates[v] = count > 0 ? rate / count : rate;
+		}
+		for (int i = 0; i < m; i++)
+		{
+			tangent_start[i] = rates[i];
+			tangent_end[i] = InverseRightJacobian(delta[i], rates[(i + 1) % n]);
+		}
+		return true;
+	}
+
+	/**
+	Evaluate the pose at parameter t. Outside the parameter range
+	an open spline is clamped and a closed one is wrapped around
+	*/
+	void Evaluate(double t, PoseSample& out) const
+	{
+		const int i = FindSegment(t, -1);
+		EvaluateSegment(i, t, out);
+	}
+
+	/**
+	Evaluate the poses at n parameters without allocation; for increasing
+	parameters every lookup continues from the previous segment
+	*/
+	void Evaluate(const double* t, std::size_t n, PoseSample* out) const
+	{
+		int hint = 0;
+		for (std::size_t k = 0; k < n; k++)
+		{
+			double tk = t[k];
+			hint = FindSegment(tk, hint);
+			EvaluateSegment(hint, tk, out[k]);
+		}
+	}
+
+	Quaternion q(double t) const
+	{
+		PoseSample sample;
+		Evaluate(t, sample);
+		return sample.orientation;
+	}
+
+	/**
+	Body angular velocity at parameter t
+	*/
+	Vector3 omega(double t) const
+	{
+		PoseSample sample;
+		Evaluate(t, sample);
+		return sample.angular_velocity;
+	}
+
+	/**
+	Body angular acceleration at parameter t
+	*/
+	Vector3 alpha(double t) const
+	{
+		PoseSample sample;
+		Evaluate(t, sample);
+		return sample.angular_acceleration;
+	}
+};
+
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * quaternion.hpp
+ *
+ * Header file for a general-purpose unit quaternion
+ * representing 3D orientations
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_QUATERNION_HPP
+#define CATMULL_ROS_QUATERNION_HPP
+
+#include <cmath>
+
+#include "vector3.hpp"
+
+namespace catmull_ros {
+
+const double QUATERNION_SMALL_ANGLE = 1e-8;
+
+/**
+ * catmull_ros::Quaternion
+ *
+ * Hamilton quaternion w + xi + yj + zk, used as a rotation when normalized.
+ * The rotation vector (axis times angle) maps to and from it through
+ * Exp() and Log().
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+struct Quaternion
+{
+	double w;
+	double x;
+	double y;
+	double z;
+
+	Quaternion(): w(1.0), x(0.0), y(0.0), z(0.0) {}
+	Quaternion(double w, double x, double y, double z): w(w), x(x), y(y), z(z) {}
+
+	Quaternion Conjugate() const
+	{
+		return Quaternion(w, -x, -y, -z);
+	}
+
+	double GetNorm() const
+	{
+		return sqrt(w*w + x*x + y*y + z*z);
+	}
+
+	Quaternion Normalized() const
+	{
+		const double n = GetNorm();
+		return Quaternion(w/n, x/n, y/n, z/n);
+	}
+
+	Vector3 Vec() const
+	{
+		return Vector3(x, y, z);
+	}
+
+	/**
+	Rotate the vector v by this (unit) quaternion
+	*/
+	Vector3 Rotate(const Vector3& v) const
+	{
+		const Vector3 u(x, y, z);
+		const Vector3 t = 2.0*Cross(u, v);
+		return v + w*t + Cross(u, t);
+	}
+
+	/**
+	Quaternion of the rotation vector phi
+	*/
+	static Quaternion Exp(const Vector3& phi)
+	{
+		const double theta = sqrt(Dot(phi, phi));
+		if (theta < QUATERNION_SMALL_ANGLE)
+		{
+			return Quaternion(1.0, 0.5*phi.coords[0], 0.5*phi.coords[1],
+				0.5*phi.coords[2]).Normalized();
+		}
+		const double s = sin(0.5*theta) / theta;
+		return Quaternion(cos(0.5*theta), s*phi.coords[0], s*phi.coords[1],
+			s*phi.coords[2]);
+	}
+
+	/**
+	Rotation vector of this (unit) quaternion, with angle in [0, pi]
+	*/
+	Vector3 Log() const
+	{
+		const double sign = w < 0.0 ? -1.0 : 1.0;
+		const Vector3 v(sign*x, sign*y, sign*z);
+		const double n = sqrt(Dot(v, v));
+		if (n < QUATERNION_SMALL_ANGLE)
+		{
+			return (2.0 / (sign*w)) * v;
+		}
+		return (2.0*atan2(n, sign*w) / n) * v;
+	}
+};
+
+inline Quaternion operator*(const Quaternion& lhs, const Quaternion& rhs)
+{
+	return Quaternion(
+		lhs.w*rhs.w - lhs.x*rhs.x - lhs.y*rhs.y - lhs.z*rhs.z,
+		lhs.w*rhs.x + lhs.x*rhs.w + lhs.y*rhs.z - lhs.z*rhs.y,
+		lhs.w*rhs.y - lhs.x*rhs.z + lhs.y*rhs.w + lhs.z*rhs.x,
+		lhs.w*rhs.z + lhs.x*rhs.y - lhs.y*rhs.x + lhs.z*rhs.w);
+}
+
+}
+#endif
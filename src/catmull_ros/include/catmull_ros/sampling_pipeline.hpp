@@ -0,0 +1,574 @@
+/*
+ * sampling_pipeline.hpp
+ *
+ * Header file for lazy, composable sampling pipelines over Catmull-Rom
+ * splines (sample, map, filter and consume in chunks in a single pass)
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_SAMPLING_PIPELINE_HPP
+#define CATMULL_ROS_SAMPLING_PIPELINE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include "arc_length.hpp"
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+// Maximal subdivision depth of a segment in adaptive sampling
+const int ADAPTIVE_SAMPLING_MAX_DEPTH = 16;
+
+/**
+ * catmull_ros::PathSample
+ *
+ * Point of a spline produced by the sampling sources
+ */
+struct PathSample
+{
+	int segment;
+	double t;
+	Vector3 p;
+
+	PathSample(): segment(-1), t(0.0) {}
+	PathSample(int segment, double t, const Vector3& p): segment(segment), t(t), p(p) {}
+};
+
+template <typename Source, typename F> class MapStage;
+template <typename Source, typename Predicate> class FilterStage;
+
+/**
+ * catmull_ros::SamplingStage
+ *
+ * Common interface of the pipeline stages. Every stage is a cheap value
+ * describing the computation, nothing is evaluated until the pipeline is
+ * consumed. A stage has Size() work units (samples or segments of the
+ * source) and opens cursors over unit ranges, whose Next() produces the
+ * values one by one through the whole chain of stages.
+ *
+ * The consumers see the values in chunks of a fixed size buffer, so the
+ * scratch memory does not depend on the length of the path. The stage
+ * functions must be thread-safe for ParallelForEachChunk.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+template <typename Derived>
+class SamplingStage
+{
+private:
+	const Derived& Self() const
+	{
+		return static_cast<const Derived&>(*this);
+	}
+
+	template <typename Cursor, typename Value, typename Consumer>
+	static void Drain(Cursor& cursor, std::vector<Value>& buffer, Consumer& consumer)
+	{
+		std::size_t count = 0;
+		while (cursor.Next(buffer[count]))
+		{
+			if (++count == buffer.size())
+			{
+				consumer(buffer.data(), count);
+				count = 0;
+			}
+		}
+		if (count > 0)
+		{
+			consumer(buffer.data(), count);
+		}
+	}
+public:
+	/**
+	Transform every value with f
+	*/
+	template <typename F>
+	MapStage<Derived, F> Map(F f) const
+	{
+		return MapStage<Derived, F>(Self(), f);
+	}
+
+	/**
+	Keep the values satisfying the predicate
+	*/
+	template <typename Predicate>
+	FilterStage<Derived, Predicate> Filter(Predicate predicate) const
+	{
+		return FilterStage<Derived, Predicate>(Self(), predicate);
+	}
+
+	/**
+	Stream the values in order through consumer(const value_type*, count),
+	at most chunk_size values at a time
+	*/
+	template <typename Consumer>
+	void ForEachChunk(std::size_t chunk_size, Consumer consumer) const
+	{
+		typedef typename Derived::value_type Value;
+		std::vector<Value> buffer(std::max<std::size_t>(1, chunk_size));
+		typename Derived::Cursor cursor = Self().Begin(0, Self().Size());
+		Drain(cursor, buffer, consumer);
+	}
+
+	/**
+	Split the work units into parts of units_per_part and stream the parts
+	in parallel through consumer(part, const value_type*, count). The
+	chunks of a part arrive in order, the parts in any order. Each thread
+	reuses a single buffer of chunk_size values
+	*/
+	template <typename Consumer>
+	void ParallelForEachChunk(std::size_t chunk_size, std::size_t units_per_part,
+		Consumer consumer) const
+	{
+		typedef typename Derived::value_type Value;
+		const std::size_t size = Self().Size();
+		units_per_part = std::max<std::size_t>(1, units_per_part);
+		const std::size_t parts = (size + units_per_part - 1) / units_per_part;
+		tbb::enumerable_thread_specific<std::vector<Value> > buffers(
+			std::vector<Value>(std::max<std::size_t>(1, chunk_size)));
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, parts, 1),
+			[&](const tbb::blocked_range<std::size_t>& range)
+			{
+				std::vector<Value>& buffer = buffers.local();
+				for (std::size_t part = range.begin(); part != range.end(); part++)
+				{
+					typename Derived::Cursor cursor = Self().Begin(part*units_per_part,
+						std::min(size, (part + 1)*units_per_part));
+					auto part_consumer = [&](const Value* data, std::size_t count)
+					{
+						consumer(part, data, count);
+					};
+					Drain(cursor, buffer, part_consumer);
+				}
+			});
+	}
+
+	/**
+	Append every value to out (materializes the pipeline)
+	*/
+	template <typename Container>
+	void Collect(Container& out) const
+	{
+		ForEachChunk(256, [&](const typename Derived::value_type* data, std::size_t count)
+			{
+				out.insert(out.end(), data, data + count);
+			});
+	}
+};
+
+/**
+ * catmull_ros::MapStage
+ *
+ * Applies f to the values of the source
+ */
+template <typename Source, typename F>
+class MapStage: public SamplingStage<MapStage<Source, F> >
+{
+private:
+	Source source;
+	F f;
+public:
+	typedef typename Source::value_type input_type;
+	typedef typename std::decay<decltype(std::declval<const F&>()(
+		std::declval<const input_type&>()))>::type value_type;
+
+	class Cursor
+	{
+	private:
+		typename Source::Cursor inner;
+		const F* f;
+		input_type scratch;
+	public:
+		Cursor(const typename Source::Cursor& inner, const F* f): inner(inner), f(f)
+		{
+		}
+
+		bool Next(value_type& out)
+		{
+			if (!inner.Next(scratch))
+			{
+				return false;
+			}
+			out = (*f)(scratch);
+			return true;
+		}
+	};
+
+	MapStage(const Source& source, F f): source(source), f(f)
+	{
+	}
+
+	std::size_t Size() const
+	{
+		return source.Size();
+	}
+
+	Cursor Begin(std::size_t first, std::size_t last) const
+	{
+		return Cursor(source.Begin(first, last), &f);
+	}
+};
+
+/**
+ * catmull_ros::FilterStage
+ *
+ * Passes the values of the source satisfying the predicate
+ */
+template <typename Source, typename Predicate>
+class FilterStage: public SamplingStage<FilterStage<Source, Predicate> >
+{
+private:
+	Source source;
+	Predicate predicate;
+public:
+	typedef typename Source::value_type value_type;
+
+	class Cursor
+	{
+	private:
+		typename Source::Cursor inner;
+		const Predicate* predicate;
+	public:
+		Cursor(const typename Source::Cursor& inner, const Predicate* predicate):
+			inner(inner), predicate(predicate)
+		{
+		}
+
+		bool Next(value_type& out)
+		{
+			while (inner.Next(out))
+			{
+				if ((*predicate)(out))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	FilterStage(const Source& source, Predicate predicate): source(source), predicate(predicate)
+	{
+	}
+
+	std::size_t Size() const
+	{
+		return source.Size();
+	}
+
+	Cursor Begin(std::size_t first, std::size_t last) const
+	{
+		return Cursor(source.Begin(first, last), &predicate);
+	}
+};
+
+/*
+Segments of a constructed spline shared by the copies of a source. The
+spline must outlive the pipeline and must not be modified meanwhile
+*/
+struct SamplingSegments
+{
+	std::vector<ControlVertex*> segments;
+	// Pending knot shift of every segment (see CatmullSpline::GetKnotOffset)
+	std::vector<double> offset;
+	std::vector<double> t_start;
+	std::vector<double> t_end;
+
+	explicit SamplingSegments(CatmullSpline& spline)
+	{
+		const int n = spline.GetNumberOfSegments();
+		segments.resize(n);
+		offset.resize(n);
+		t_start.resize(n);
+		t_end.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			segments[i] = spline.GetControlVertex(i).get();
+			offset[i] = spline.GetKnotOffset(i);
+			t_start[i] = spline.GetSegmentStartT(i);
+			t_end[i] = spline.GetSegmentEndT(i);
+		}
+	}
+
+	/*
+	Position of segment i at the spline parameter t
+	*/
+	Vector3 Position(int i, double t) const
+	{
+		return segments[i]->Hermite(t - offset[i]);
+	}
+
+	/*
+	Segment of t (clamped to the segments)
+	*/
+	int Find(double t) const
+	{
+		const int i = static_cast<int>(std::upper_bound(t_start.begin(), t_start.end(), t)
+			- t_start.begin()) - 1;
+		return std::max(0, std::min(static_cast<int>(segments.size()) - 1, i));
+	}
+};
+
+/**
+ * catmull_ros::UniformTSampler
+ *
+ * n samples uniformly in the parameter, from the first to the last
+ * parameter of the spline. A work unit is a sample
+ */
+class UniformTSampler: public SamplingStage<UniformTSampler>
+{
+private:
+	std::shared_ptr<const SamplingSegments> data;
+	std::size_t n;
+public:
+	typedef PathSample value_type;
+
+	class Cursor
+	{
+	private:
+		const SamplingSegments* data;
+		std::size_t i;
+		std::size_t last;
+		std::size_t n;
+		int segment;
+	public:
+		Cursor(const SamplingSegments* data, std::size_t first, std::size_t last, std::size_t n):
+			data(data), i(first), last(last), n(n), segment(0)
+		{
+			if (i < last)
+			{
+				segment = data->Find(T(i));
+			}
+		}
+
+		double T(std::size_t k) const
+		{
+			const double t0 = data->t_start.front();
+			const double t1 = data->t_end.back();
+			return n > 1 ? t0 + (t1 - t0)*k/(n - 1) : t0;
+		}
+
+		bool Next(PathSample& out)
+		{
+			if (i >= last)
+			{
+				return false;
+			}
+			const double t = T(i++);
+			// The parameters increase, the segment only moves forward
+			while (segment + 1 < static_cast<int>(data->segments.size())
+				&& t >= data->t_start[segment + 1])
+			{
+				segment++;
+			}
+			out = PathSample(segment, t, data->Position(segment, t));
+			return true;
+		}
+	};
+
+	UniformTSampler(CatmullSpline& spline, std::size_t n):
+		data(new SamplingSegments(spline)), n(n)
+	{
+	}
+
+	std::size_t Size() const
+	{
+		return data->segments.empty() ? 0 : n;
+	}
+
+	Cursor Begin(std::size_t first, std::size_t last) const
+	{
+		return Cursor(data.get(), first, last, n);
+	}
+};
+
+/**
+ * catmull_ros::UniformSSampler
+ *
+ * Samples every step of arc length from the start of the spline, and its
+ * end point. A work unit is a sample
+ */
+class UniformSSampler: public SamplingStage<UniformSSampler>
+{
+private:
+	std::shared_ptr<const SamplingSegments> data;
+	std::shared_ptr<const ArcLengthTable> arc;
+	double step;
+	std::size_t n;
+public:
+	typedef PathSample value_type;
+
+	class Cursor
+	{
+	private:
+		const SamplingSegments* data;
+		const ArcLengthTable* arc;
+		double step;
+		std::size_t i;
+		std::size_t last;
+	public:
+		Cursor(const SamplingSegments* data, const ArcLengthTable* arc, double step,
+			std::size_t first, std::size_t last):
+			data(data), arc(arc), step(step), i(first), last(last)
+		{
+		}
+
+		bool Next(PathSample& out)
+		{
+			if (i >= last)
+			{
+				return false;
+			}
+			int segment;
+			double t;
+			arc->Invert(std::min(arc->TotalLength(), step*i++), segment, t);
+			out = PathSample(segment, t, data->Position(segment, t));
+			return true;
+		}
+	};
+
+	UniformSSampler(CatmullSpline& spline, double step):
+		data(new SamplingSegments(spline)), arc(new ArcLengthTable(spline)), step(step), n(0)
+	{
+		if (!data->segments.empty() && step > 0.0)
+		{
+			n = static_cast<std::size_t>(ceil(arc->TotalLength() / step)) + 1;
+		}
+	}
+
+	std::size_t Size() const
+	{
+		return n;
+	}
+
+	Cursor Begin(std::size_t first, std::size_t last) const
+	{
+		return Cursor(data.get(), arc.get(), step, first, last);
+	}
+};
+
+/**
+ * catmull_ros::AdaptiveSampler
+ *
+ * Subdivides each segment until the midpoint of every piece deviates
+ * from its chord by at most the tolerance (every segment is split at
+ * least once), emitting the piece start points and the end of the spline.
+ * A work unit is a segment, the subdivision stack is bounded by the
+ * maximal depth
+ */
+class AdaptiveSampler: public SamplingStage<AdaptiveSampler>
+{
+private:
+	std::shared_ptr<const SamplingSegments> data;
+	double tolerance;
+public:
+	typedef PathSample value_type;
+
+	class Cursor
+	{
+	private:
+		struct Piece
+		{
+			double t0;
+			double t1;
+			int depth;
+		};
+
+		const SamplingSegments* data;
+		double tolerance2;
+		std::size_t segment;
+		std::size_t last;
+		bool end_pending;
+		Piece stack[ADAPTIVE_SAMPLING_MAX_DEPTH + 2];
+		int top;
+
+		bool Flat(int i, const Piece& piece) const
+		{
+			const Vector3 a = data->Position(i, piece.t0);
+			const Vector3 b = data->Position(i, piece.t1);
+			const Vector3 m = data->Position(i, 0.5*(piece.t0 + piece.t1));
+			const Vector3 chord = b - a;
+			const Vector3 d = m - a;
+			const double length2 = Dot(chord, chord);
+			const double u = length2 > 0.0 ? std::max(0.0, std::min(1.0, Dot(d, chord) / length2)) : 0.0;
+			const Vector3 e = d - u*chord;
+			return Dot(e, e) <= tolerance2;
+		}
+	public:
+		Cursor(const SamplingSegments* data, double tolerance, std::size_t first, std::size_t last):
+			data(data), tolerance2(tolerance*tolerance), segment(first), last(last),
+			end_pending(last == data->segments.size() && first < last), top(0)
+		{
+		}
+
+		bool Next(PathSample& out)
+		{
+			while (true)
+			{
+				if (top == 0)
+				{
+					if (segment >= last)
+					{
+						if (end_pending)
+						{
+							// End point of the spline
+							end_pending = false;
+							const int i = static_cast<int>(data->segments.size()) - 1;
+							out = PathSample(i, data->t_end[i], data->Position(i, data->t_end[i]));
+							return true;
+						}
+						return false;
+					}
+					Piece piece;
+					piece.t0 = data->t_start[segment];
+					piece.t1 = data->t_end[segment];
+					piece.depth = 0;
+					stack[top++] = piece;
+					segment++;
+				}
+				const Piece piece = stack[--top];
+				const int i = static_cast<int>(segment) - 1;
+				if (piece.depth >= ADAPTIVE_SAMPLING_MAX_DEPTH || (piece.depth > 0 && Flat(i, piece)))
+				{
+					out = PathSample(i, piece.t0, data->Position(i, piece.t0));
+					return true;
+				}
+				// Left half on top, so the pieces are emitted in order
+				const double mid = 0.5*(piece.t0 + piece.t1);
+				Piece right = {mid, piece.t1, piece.depth + 1};
+				Piece left = {piece.t0, mid, piece.depth + 1};
+				stack[top++] = right;
+				stack[top++] = left;
+			}
+		}
+	};
+
+	AdaptiveSampler(CatmullSpline& spline, double tolerance):
+		data(new SamplingSegments(spline)), tolerance(tolerance)
+	{
+	}
+
+	std::size_t Size() const
+	{
+		return data->segments.size();
+	}
+
+	Cursor Begin(std::size_t first, std::size_t last) const
+	{
+		return Cursor(data.get(), tolerance, first, last);
+	}
+};
+
+}
+#endif
@@ -0,0 +1,494 @@
+/*
+ * segment_bvh.hpp
+ *
+ * Header file for a bounding volume hierarchy over the Hermite
+ * segments of a Catmull-Rom spline
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_SEGMENT_BVH_HPP
+#define CATMULL_ROS_SEGMENT_BVH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+const int SEGMENT_BVH_LEAF_SIZE = 4;
+
+/**
+ * catmull_ros::BoundingBox
+ *
+ * Axis-aligned bounding box
+ */
+struct BoundingBox
+{
+	Vector3 min;
+	Vector3 max;
+
+	BoundingBox():
+		min(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+			std::numeric_limits<double>::max()),
+		max(-std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+			-std::numeric_limits<double>::max())
+	{
+	}
+
+	void Extend(const Vector3& p)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			min.coords[k] = std::min(min.coords[k], p.coords[k]);
+			max.coords[k] = std::max(max.coords[k], p.coords[k]);
+		}
+	}
+
+	void Extend(const BoundingBox& box)
+	{
+		Extend(box.min);
+		Extend(box.max);
+	}
+
+	Vector3 Center() const
+	{
+		return 0.5*(min + max);
+	}
+
+	/**
+	Squared distance of q from the box (0 inside)
+	*/
+	double SquaredDistance(const Vector3& q) const
+	{
+		double sum = 0.0;
+		for (int k = 0; k < 3; k++)
+		{
+			double d = 0.0;
+			if (q.coords[k] < min.coords[k])
+			{
+				d = min.coords[k] - q.coords[k];
+			}
+			else if (q.coords[k] > max.coords[k])
+			{
+				d = q.coords[k] - max.coords[k];
+			}
+			sum += d*d;
+		}
+		return sum;
+	}
+
+	/**
+	Squared distance between two boxes (0 if they overlap)
+	*/
+	double SquaredDistance(const BoundingBox& box) const
+	{
+		double sum = 0.0;
+		for (int k = 0; k < 3; k++)
+		{
+			double d = 0.0;
+			if (box.max.coords[k] < min.coords[k])
+			{
+				d = min.coords[k] - box.max.coords[k];
+			}
+			else if (box.min.coords[k] > max.coords[k])
+			{
+				d = box.min.coords[k] - max.coords[k];
+			}
+			sum += d*d;
+		}
+		return sum;
+	}
+};
+
+/**
+Conservative bounding box of the Hermite segment [t0, t1] of cv: the box
+of its Bezier control points, which contain the curve in their convex hull
+*/
+inline BoundingBox HermiteSegmentBox(ControlVertex& cv, double t0, double t1)
+{
+	const double h = t1 - t0;
+	const Vector3 p0 = cv.Hermite(t0);
+	const Vector3 p1 = cv.Hermite(t1);
+	BoundingBox box;
+	box.Extend(p0);
+	box.Extend(p0 + (h/3.0)*cv.dhermite(t0));
+	box.Extend(p1 - (h/3.0)*cv.dhermite(t1));
+	box.Extend(p1);
+	return box;
+}
+
+/**
+ * catmull_ros::SegmentBvh
+ *
+ * Bounding volume hierarchy of the segments of a constructed spline,
+ * answering closest-point queries with box pruning. A hint segment (e.g.
+ * the answer for a nearby point) gives an initial bound, so coherent
+ * queries prune most of the tree.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class SegmentBvh
+{
+private:
+	struct Node
+	{
+		BoundingBox box;
+		// Children for inner nodes, a range of order for leaves
+		int left;
+		int right;
+		int first;
+		int count;
+	};
+	std::vector<Node> nodes;
+	std::vector<int> order;
+	std::vector<BoundingBox> boxes;
+	std::vector<ControlVertex*> segments;
+	// Pending knot shift of every segment (see CatmullSpline::GetKnotOffset)
+	std::vector<double> offset;
+	std::vector<double> t_end;
+	std::uint64_t version;
+
+	int BuildNode(int first, int count)
+	{
+		Node node;
+		node.left = -1;
+		node.right = -1;
+		node.first = first;
+		node.count = count;
+		BoundingBox centers;
+		for (int i = first; i < first + count; i++)
+		{
+			node.box.Extend(boxes[order[i]]);
+			centers.Extend(boxes[order[i]].Center());
+		}
+		const int index = static_cast<int>(nodes.size());
+		nodes.push_back(node);
+		if (count > SEGMENT_BVH_LEAF_SIZE)
+		{
+			int axis = 0;
+			for (int k = 1; k < 3; k++)
+			{
+				if (centers.max.coords[k] - centers.min.coords[k] >
+					centers.max.coords[axis] - centers.min.coords[axis])
+				{
+					axis = k;
+				}
+			}
+			const int half = count / 2;
+			std::nth_element(order.begin() + first, order.begin() + first + half,
+				order.begin() + first + count,
+				[&](int a, int b)
+				{
+					return boxes[a].Center().coords[axis] < boxes[b].Center().coords[axis];
+				});
+			const int left = BuildNode(first, half);
+			const int right = BuildNode(first + half, count - half);
+			nodes[index].left = left;
+			nodes[index].right = right;
+			nodes[index].count = 0;
+		}
+		return index;
+	}
+
+	void TestSegment(int i, const Vector3& q, int& best, double& best_d2, double& best_t) const
+	{
+		const double t = segments[i]->ClosestParameter(q, t_end[i] - offset[i]);
+		const Vector3 d = segments[i]->Hermite(t) - q;
+		const double d2 = Dot(d, d);
+		if (d2 < best_d2)
+		{
+			best_d2 = d2;
+			best = i;
+			best_t = t + offset[i];
+		}
+	}
+
+	/*
+	Refresh the segments from the spline, recomputing the dirty boxes
+	*/
+	void Refresh(CatmullSpline& spline, const std::vector<char>& dirty)
+	{
+		const int n = spline.GetNumberOfSegments();
+		boxes.resize(n);
+		segments.resize(n);
+		offset.resize(n);
+		t_end.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			segments[i] = spline.GetControlVertex(i).get();
+			offset[i] = spline.GetKnotOffset(i);
+			t_end[i] = spline.GetSegmentEndT(i);
+			if (dirty[i])
+			{
+				boxes[i] = HermiteSegmentBox(*segments[i], segments[i]->T(), t_end[i] - offset[i]);
+			}
+		}
+		version = spline.GetVersion();
+	}
+
+	void BuildTree()
+	{
+		const int n = GetNumberOfSegments();
+		nodes.clear();
+		order.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			order[i] = i;
+		}
+		if (n > 0)
+		{
+			BuildNode(0, n);
+		}
+	}
+
+	/*
+	Recompute the boxes of the nodes bottom-up, keeping the tree
+	*/
+	void Refit()
+	{
+		// Children are always stored after their parent
+		for (int k = static_cast<int>(nodes.size()) - 1; k >= 0; k--)
+		{
+			Node& node = nodes[k];
+			node.box = BoundingBox();
+			if (node.left < 0)
+			{
+				for (int i = node.first; i < node.first + node.count; i++)
+				{
+					node.box.Extend(boxes[order[i]]);
+				}
+			}
+			else
+			{
+				node.box.Extend(nodes[node.left].box);
+				node.box.Extend(nodes[node.right].box);
+			}
+		}
+	}
+
+public:
+	SegmentBvh(): version(0)
+	{
+	}
+
+	explicit SegmentBvh(CatmullSpline& spline)
+	{
+		Build(spline);
+	}
+
+	void Build(CatmullSpline& spline)
+	{
+		Refresh(spline, std::vector<char>(spline.GetNumberOfSegments(), 1));
+		BuildTree();
+	}
+
+	/**
+	Bring the hierarchy up to date with the local edits of the spline since
+	it was built: only the boxes of the replaced segments are recomputed.
+	The tree is refitted if the number of segments did not change and
+	rebuilt from the boxes otherwise
+	*/
+	void Update(CatmullSpline& spline)
+	{
+		std::vector<SplineChange> changes;
+		if (!spline.GetChanges(version, changes))
+		{
+			Build(spline);
+			return;
+		}
+		if (changes.empty())
+		{
+			return;
+		}
+		std::vector<char> dirty(boxes.size(), 0);
+		for (std::size_t k = 0; k < changes.size(); k++)
+		{
+			const SplineChange& c = changes[k];
+			boxes.erase(boxes.begin() + c.first, boxes.begin() + c.first + c.removed);
+			boxes.insert(boxes.begin() + c.first, c.added, BoundingBox());
+			dirty.erase(dirty.begin() + c.first, dirty.begin() + c.first + c.removed);
+			dirty.insert(dirty.begin() + c.first, c.added, 1);
+		}
+		const int previous = GetNumberOfSegments();
+		Refresh(spline, dirty);
+		if (GetNumberOfSegments() == previous && !nodes.empty())
+		{
+			Refit();
+		}
+		else
+		{
+			BuildTree();
+		}
+	}
+
+	int GetNumberOfSegments() const
+	{
+		return static_cast<int>(segments.size());
+	}
+
+	const BoundingBox& GetSegmentBox(int i) const
+	{
+		return boxes[i];
+	}
+
+	const BoundingBox& GetBounds() const
+	{
+		return nodes[0].box;
+	}
+
+	/**
+	Closest point of the spline to q: returns its segment (-1 for an empty
+	tree) and sets its parameter and squared distance. Only segments closer
+	than max_d2 and than the hint segment are considered
+	*/
+	int Closest(const Vector3& q, double& t, double& d2, int hint=-1,
+		double max_d2=std::numeric_limits<double>::max()) const
+	{
+		int best = -1;
+		double best_d2 = max_d2;
+		double best_t = 0.0;
+		if (nodes.empty())
+		{
+			d2 = best_d2;
+			return best;
+		}
+		if (hint >= 0 && hint < GetNumberOfSegments())
+		{
+			TestSegment(hint, q, best, best_d2, best_t);
+		}
+		int stack[64];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			const Node& node = nodes[stack[--top]];
+			if (node.box.SquaredDistance(q) >= best_d2)
+			{
+				continue;
+			}
+			if (node.left < 0)
+			{
+				for (int k = node.first; k < node.first + node.count; k++)
+				{
+					if (order[k] != hint && boxes[order[k]].SquaredDistance(q) < best_d2)
+					{
+						TestSegment(order[k], q, best, best_d2, best_t);
+					}
+				}
+				continue;
+			}
+			// Visit the nearer child first
+			const double dl = nodes[node.left].box.SquaredDistance(q);
+			const double dr = nodes[node.right].box.SquaredDistance(q);
+			if (dl < dr)
+			{
+				stack[top++] = node.right;
+				stack[top++] = node.left;
+			}
+			else
+			{
+				stack[top++] = node.left;
+				stack[top++] = node.right;
+			}
+		}
+		t = best_t;
+		d2 = best_d2;
+		return best;
+	}
+
+	/**
+	True if some segment is closer to q than sqrt(d2). The search starts
+	with the hint segment and stops at the first segment found
+	*/
+	bool AnyWithin(const Vector3& q, double d2, int hint=-1) const
+	{
+		if (nodes.empty() || d2 <= 0.0)
+		{
+			return false;
+		}
+		int best = -1;
+		double best_d2 = d2;
+		double best_t = 0.0;
+		if (hint >= 0 && hint < GetNumberOfSegments())
+		{
+			TestSegment(hint, q, best, best_d2, best_t);
+			if (best >= 0)
+			{
+				return true;
+			}
+		}
+		int stack[64];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			const Node& node = nodes[stack[--top]];
+			if (node.box.SquaredDistance(q) >= d2)
+			{
+				continue;
+			}
+			if (node.left < 0)
+			{
+				for (int k = node.first; k < node.first + node.count; k++)
+				{
+					if (order[k] != hint && boxes[order[k]].SquaredDistance(q) < d2)
+					{
+						TestSegment(order[k], q, best, best_d2, best_t);
+						if (best >= 0)
+						{
+							return true;
+						}
+					}
+				}
+				continue;
+			}
+			stack[top++] = node.left;
+			stack[top++] = node.right;
+		}
+		return false;
+	}
+
+	/**
+	Collect the segments whose box lies within distance r of the box
+	*/
+	void Query(const BoundingBox& box, double r, std::vector<int>& result) const
+	{
+		result.clear();
+		if (nodes.empty())
+		{
+			return;
+		}
+		const double r2 = r*r;
+		int stack[64];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			const Node& node = nodes[stack[--top]];
+			if (node.box.SquaredDistance(box) > r2)
+			{
+				continue;
+			}
+			if (node.left < 0)
+			{
+				for (int k = node.first; k < node.first + node.count; k++)
+				{
+					if (boxes[order[k]].SquaredDistance(box) <= r2)
+					{
+						result.push_back(order[k]);
+					}
+				}
+				continue;
+			}
+			stack[top++] = node.left;
+			stack[top++] = node.right;
+		}
+	}
+};
+
+}
+#endif
@@ -0,0 +1,437 @@
+/*
+ * shared_spline.hpp
+ *
+ * Header file for publishing constructed Catmull-Rom splines to other
+ * processes through POSIX shared memory
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_SHARED_SPLINE_HPP
+#define CATMULL_ROS_SHARED_SPLINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+const std::uint32_t SHARED_SPLINE_MAGIC = 0x43524f53;
+// Attempts of a reader to get a consistent version before giving up
+const int SHARED_SPLINE_READ_ATTEMPTS = 1000;
+
+/**
+ * catmull_ros::SharedHermiteSegment
+ *
+ * Plain copy of the Hermite coefficients of one segment, valid on
+ * [t0, t1]: r(t) = a[3]*dt^3 + a[2]*dt^2 + a[1]*dt + a[0], dt = t - t0
+ */
+struct SharedHermiteSegment
+{
+	double t0;
+	double t1;
+	double a[4][3];
+};
+
+/*
+Layout of the shared memory region: the header is followed by capacity
+segments. The data is guarded by a seqlock, sequence is odd while the
+publisher is writing
+*/
+struct SharedSplineHeader
+{
+	std::uint32_t magic;
+	std::uint32_t capacity;
+	std::atomic<std::uint32_t> sequence;
+	std::uint32_t segments;
+	std::uint32_t closed;
+	std::uint32_t reserved;
+	// steady_clock time of the publication in nanoseconds
+	std::int64_t publish_time;
+};
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+	"the sequence counter must be a plain word to be shared between processes");
+
+inline std::size_t SharedSplineSize(std::uint32_t capacity)
+{
+	return sizeof(SharedSplineHeader) + capacity*sizeof(SharedHermiteSegment);
+}
+
+inline std::int64_t SharedSplineClock()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * catmull_ros::SharedSplinePublisher
+ *
+ * Owns a named POSIX shared memory region (e.g. "/planner_path") and
+ * writes the coefficients of constructed splines into it. Publishing is
+ * wait-free for the writer, readers retry if they overlap a publication.
+ * There must be a single publisher per region. The region outlives the
+ * publisher, so a restarted publisher continues it and the attached
+ * views see its data; Remove() deletes the name explicitly.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class SharedSplinePublisher
+{
+private:
+	std::string name;
+	std::uint32_t capacity;
+	void* memory;
+	SharedSplineHeader* header;
+	SharedHermiteSegment* data;
+
+	SharedSplinePublisher(const SharedSplinePublisher&);
+	SharedSplinePublisher& operator=(const SharedSplinePublisher&);
+public:
+	/**
+	Create (or reuse) the region for at most capacity segments. A region
+	left by a previous publisher with the same capacity keeps its data and
+	its version, which is advanced (so it never goes backwards for the
+	readers). A region of another capacity (or not written by a publisher)
+	is never resized under its readers: the publisher is not opened, the
+	region has to be removed first
+	*/
+	SharedSplinePublisher(const std::string& name, std::uint32_t capacity):
+		name(name), capacity(capacity), memory(MAP_FAILED), header(nullptr), data(nullptr)
+	{
+		const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+		if (fd < 0)
+		{
+			return;
+		}
+		const std::size_t size = SharedSplineSize(capacity);
+		struct stat st;
+		if (fstat(fd, &st) != 0 || (st.st_size != 0 && st.st_size != static_cast<off_t>(size)))
+		{
+			close(fd);
+			return;
+		}
+		const bool existing = st.st_size != 0;
+		if (existing || ftruncate(fd, size) == 0)
+		{
+			memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		if (memory == MAP_FAILED)
+		{
+			return;
+		}
+		SharedSplineHeader* h = static_cast<SharedSplineHeader*>(memory);
+		if (existing && (h->magic != SHARED_SPLINE_MAGIC || h->capacity != capacity))
+		{
+			munmap(memory, size);
+			memory = MAP_FAILED;
+			return;
+		}
+		header = h;
+		data = reinterpret_cast<SharedHermiteSegment*>(header + 1);
+		if (existing)
+		{
+			// An odd sequence is a publication left unfinished: its data is dropped
+			const std::uint32_t seq = header->sequence.load(std::memory_order_relaxed);
+			if (seq & 1)
+			{
+				header->segments = 0;
+			}
+			header->sequence.store((seq | 1) + 1, std::memory_order_release);
+			return;
+		}
+		header = new (memory) SharedSplineHeader();
+		header->capacity = capacity;
+		header->segments = 0;
+		header->closed = 0;
+		header->publish_time = 0;
+		header->sequence.store(0, std::memory_order_relaxed);
+		header->magic = SHARED_SPLINE_MAGIC;
+	}
+
+	~SharedSplinePublisher()
+	{
+		if (memory != MAP_FAILED)
+		{
+			munmap(memory, SharedSplineSize(capacity));
+		}
+	}
+
+	/**
+	Delete the named region. Mapped publishers and views stay valid, new
+	ones create a new region
+	*/
+	static bool Remove(const std::string& name)
+	{
+		return shm_unlink(name.c_str()) == 0;
+	}
+
+	bool IsOpen() const
+	{
+		return header != nullptr;
+	}
+
+	/**
+	Copy the coefficients of a constructed spline into the region.
+	Returns false if the region is not open or too small
+	*/
+	bool Publish(CatmullSpline& spline)
+	{
+		const int n = spline.GetNumberOfSegments();
+		if (!IsOpen() || n > static_cast<int>(capacity))
+		{
+			return false;
+		}
+		const std::uint32_t seq = header->sequence.load(std::memory_order_relaxed);
+		header->sequence.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (int i = 0; i < n; i++)
+		{
+			std::shared_ptr<ControlVertex> cv = spline.GetControlVertex(i);
+			SharedHermiteSegment& segment = data[i];
+			segment.t0 = spline.GetSegmentStartT(i);
+			segment.t1 = spline.GetSegmentEndT(i);
+			std::memcpy(segment.a[0], cv->A0().coords, sizeof(segment.a[0]));
+			std::memcpy(segment.a[1], cv->A1().coords, sizeof(segment.a[1]));
+			std::memcpy(segment.a[2], cv->A2().coords, sizeof(segment.a[2]));
+			std::memcpy(segment.a[3], cv->A3().coords, sizeof(segment.a[3]));
+		}
+		header->segments = n;
+		header->closed = spline.IsClosed() ? 1 : 0;
+		header->publish_time = SharedSplineClock();
+		header->sequence.store(seq + 2, std::memory_order_release);
+		return true;
+	}
+};
+
+/**
+ * catmull_ros::SharedSplineView
+ *
+ * Read-only mapping of a region written by a SharedSplinePublisher.
+ * r/dr/ddr are evaluated on the shared coefficients in place (no copy,
+ * no Construct), under the seqlock: an evaluation overlapping a
+ * publication is retried, so every result belongs to a single version.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class SharedSplineView
+{
+private:
+	std::size_t size;
+	void* memory;
+	const SharedSplineHeader* header;
+	const SharedHermiteSegment* data;
+
+	SharedSplineView(const SharedSplineView&);
+	SharedSplineView& operator=(const SharedSplineView&);
+
+	/*
+	Segment containing t in the current data, -1 outside of the range
+	(the end of an open spline belongs to its last segment)
+	*/
+	int FindSegment(double t, std::uint32_t segments, bool closed) const
+	{
+		if (segments == 0 || t < data[0].t0)
+		{
+			return -1;
+		}
+		const double end_t = data[segments - 1].t1;
+		if (t >= end_t)
+		{
+			return (!closed && t == end_t) ? static_cast<int>(segments) - 1 : -1;
+		}
+		int lo = 0;
+		int hi = static_cast<int>(segments) - 1;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi + 1) / 2;
+			if (data[mid].t0 <= t)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid - 1;
+			}
+		}
+		return lo;
+	}
+
+public:
+	explicit SharedSplineView(const std::string& name):
+		size(0), memory(MAP_FAILED), header(nullptr), data(nullptr)
+	{
+		const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0)
+		{
+			return;
+		}
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(SharedSplineHeader)))
+		{
+			size = st.st_size;
+			memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		if (memory == MAP_FAILED)
+		{
+			return;
+		}
+		const SharedSplineHeader* h = static_cast<const SharedSplineHeader*>(memory);
+		if (h->magic != SHARED_SPLINE_MAGIC || SharedSplineSize(h->capacity) > size)
+		{
+			munmap(memory, size);
+			memory = MAP_FAILED;
+			return;
+		}
+		header = h;
+		data = reinterpret_cast<const SharedHermiteSegment*>(header + 1);
+	}
+
+	~SharedSplineView()
+	{
+		if (memory != MAP_FAILED)
+		{
+			munmap(memory, size);
+		}
+	}
+
+	bool IsOpen() const
+	{
+		return header != nullptr;
+	}
+
+	/**
+	Number of completed publications
+	*/
+	std::uint32_t GetVersion() const
+	{
+		if (!IsOpen())
+		{
+			return 0;
+		}
+		return header->sequence.load(std::memory_order_acquire) / 2;
+	}
+
+	/**
+	Evaluate position, velocity and acceleration at parameter t.
+	Returns false (and zero vectors) if t is outside of the published
+	spline or the view is not open; version and publish_time are set to
+	the version evaluated. A read overlapping a publication is retried
+	(yielding the CPU) at most SHARED_SPLINE_READ_ATTEMPTS times, then
+	false is returned as well, e.g. if the publisher died while writing
+	*/
+	bool Evaluate(double t, Vector3& r, Vector3& dr, Vector3& ddr,
+		std::uint32_t* version=nullptr, std::int64_t* publish_time=nullptr) const
+	{
+		if (!IsOpen())
+		{
+			r = Vector3();
+			dr = Vector3();
+			ddr = Vector3();
+			if (version != nullptr)
+			{
+				*version = 0;
+			}
+			return false;
+		}
+		for (int attempt = 0; attempt < SHARED_SPLINE_READ_ATTEMPTS; attempt++)
+		{
+			if (attempt > 0)
+			{
+				std::this_thread::yield();
+			}
+			const std::uint32_t seq = header->sequence.load(std::memory_order_acquire);
+			if (seq & 1)
+			{
+				continue;
+			}
+			const std::uint32_t segments = std::min(header->segments, header->capacity);
+			const int i = FindSegment(t, segments, header->closed != 0);
+			bool found = false;
+			if (i >= 0)
+			{
+				const SharedHermiteSegment& s = data[i];
+				const double dt = t - s.t0;
+				for (int k = 0; k < 3; k++)
+				{
+					r.coords[k] = s.a[3][k]*(dt*dt*dt) + s.a[2][k]*(dt*dt) + s.a[1][k]*dt + s.a[0][k];
+					dr.coords[k] = 3.0*s.a[3][k]*(dt*dt) + 2.0*s.a[2][k]*dt + s.a[1][k];
+					ddr.coords[k] = 6.0*s.a[3][k]*dt + 2.0*s.a[2][k];
+				}
+				found = true;
+			}
+			const std::int64_t time = header->publish_time;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (header->sequence.load(std::memory_order_relaxed) != seq)
+			{
+				continue;
+			}
+			if (!found)
+			{
+				r = Vector3();
+				dr = Vector3();
+				ddr = Vector3();
+			}
+			if (version != nullptr)
+			{
+				*version = seq / 2;
+			}
+			if (publish_time != nullptr)
+			{
+				*publish_time = time;
+			}
+			return found;
+		}
+		r = Vector3();
+		dr = Vector3();
+		ddr = Vector3();
+		return false;
+	}
+
+	/**
+	Zero-order function of position according to parameter t
+	*/
+	Vector3 r(double t) const
+	{
+		Vector3 p, v, a;
+		Evaluate(t, p, v, a);
+		return p;
+	}
+
+	/**
+	First-order function of position according to parameter t
+	*/
+	Vector3 dr(double t) const
+	{
+		Vector3 p, v, a;
+		Evaluate(t, p, v, a);
+		return v;
+	}
+
+	/**
+	Second-order function of position according to parameter t
+	*/
+	Vector3 ddr(double t) const
+	{
+		Vector3 p, v, a;
+		Evaluate(t, p, v, a);
+		return a;
+	}
+};
+
+}
+#endif
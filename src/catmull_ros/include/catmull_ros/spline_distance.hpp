@@ -0,0 +1,486 @@
+/*
+ * spline_distance.hpp
+ *
+ * Header file for Hausdorff and discrete Frechet distance queries
+ * between two Catmull-Rom splines
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_SPLINE_DISTANCE_HPP
+#define CATMULL_ROS_SPLINE_DISTANCE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <queue>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "arc_length.hpp"
+#include "catmull.hpp"
+#include "segment_bvh.hpp"
+
+namespace catmull_ros
+{
+
+// Intervals shorter than this are not subdivided any further
+const double SPLINE_DISTANCE_MIN_INTERVAL = 1e-9;
+
+/**
+ * catmull_ros::DistanceBound
+ *
+ * The true distance lies in [lower, upper]
+ */
+struct DistanceBound
+{
+	double lower;
+	double upper;
+
+	DistanceBound(): lower(0.0), upper(0.0) {}
+	DistanceBound(double lower, double upper): lower(lower), upper(upper) {}
+};
+
+/**
+ * catmull_ros::SplineDistance
+ *
+ * Distance queries between two constructed splines a and b.
+ *
+ * The directed Hausdorff distance max_s d(a(s), b) is bounded by branch
+ * and bound over arc length intervals of a: d(a(s), b) is 1-Lipschitz in
+ * s, so an interval of half-width w around a point at distance d cannot
+ * exceed d + w. The distances to b are exact projections found through the
+ * segment BVH of b. Intervals that cannot raise the current maximum are
+ * dropped by a BVH query that stops at the first segment close enough, and
+ * the coarse pass over the intervals runs in parallel.
+ *
+ * The threshold queries (is every point of a within x of b) stop at the
+ * first point proven to be farther than x.
+ *
+ * The Frechet distance is the discrete one of the arc length samples of
+ * the two splines. It is decided against a threshold on the reachable band
+ * of the free space only (stopping at the first empty row) and its value
+ * is found by bisection of the decision.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class SplineDistance
+{
+private:
+	struct Curve
+	{
+		ArcLengthTable arc;
+		SegmentBvh bvh;
+		std::vector<ControlVertex*> segments;
+		// Pending knot shift of every segment (see CatmullSpline::GetKnotOffset)
+		std::vector<double> offset;
+		// Arc length intervals of width spacing
+		int intervals;
+		double spacing;
+		// Samples at the interval ends, for the discrete Frechet distance
+		std::vector<Vector3> samples;
+
+		Curve(CatmullSpline& spline, double max_spacing): arc(spline), bvh(spline),
+			segments(spline.GetNumberOfSegments()), offset(segments.size()), intervals(0), spacing(0.0)
+		{
+			for (int i = 0; i < static_cast<int>(segments.size()); i++)
+			{
+				segments[i] = spline.GetControlVertex(i).get();
+				offset[i] = spline.GetKnotOffset(i);
+			}
+			if (segments.empty())
+			{
+				return;
+			}
+			const double length = arc.TotalLength();
+			intervals = std::max(1, static_cast<int>(ceil(length / max_spacing)));
+			spacing = length / intervals;
+			samples.resize(intervals + 1);
+			tbb::parallel_for(tbb::blocked_range<int>(0, intervals + 1),
+				[&](const tbb::blocked_range<int>& range)
+				{
+					for (int k = range.begin(); k != range.end(); k++)
+					{
+						samples[k] = Position(k*spacing);
+					}
+				});
+		}
+
+		Vector3 Position(double s) const
+		{
+			int segment;
+			double t;
+			arc.Invert(s, segment, t);
+			return segments[segment]->Hermite(t - offset[segment]);
+		}
+	};
+
+	/*
+	Arc length interval [s - half, s + half] of the source curve, d is the
+	distance of its centre to the target
+	*/
+	struct Interval
+	{
+		double s;
+		double half;
+		double d;
+
+		bool operator<(const Interval& other) const
+		{
+			return d + half < other.d + other.half;
+		}
+	};
+
+	Curve a;
+	Curve b;
+
+	static void AtomicMax(std::atomic<double>& value, double x)
+	{
+		double current = value.load(std::memory_order_relaxed);
+		while (x > current && !value.compare_exchange_weak(current, x, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	static double Distance2(const Vector3& p, const Vector3& q)
+	{
+		const Vector3 d = p - q;
+		return Dot(d, d);
+	}
+
+	/*
+	Distance of the point at arc length s of the source to the target,
+	hint is the closest segment of the previous query
+	*/
+	static double PointDistance(const Curve& source, const Curve& target, double s, int& hint)
+	{
+		double t, d2;
+		const int segment = target.bvh.Closest(source.Position(s), t, d2, hint);
+		if (segment >= 0)
+		{
+			hint = segment;
+		}
+		return sqrt(d2);
+	}
+
+	DistanceBound Directed(const Curve& source, const Curve& target, double tolerance) const
+	{
+		if (source.intervals == 0 || target.intervals == 0)
+		{
+			return DistanceBound();
+		}
+		const double half = 0.5*source.spacing;
+		std::atomic<double> best(0.0);
+		std::vector<Interval> open(source.intervals);
+		std::vector<char> kept(source.intervals, 0);
+		tbb::parallel_for(tbb::blocked_range<int>(0, source.intervals),
+			[&](const tbb::blocked_range<int>& range)
+			{
+				int hint = -1;
+				for (int k = range.begin(); k != range.end(); k++)
+				{
+					const double s = (k + 0.5)*source.spacing;
+					// Cannot raise the maximum by more than the tolerance
+					const double cutoff = best.load(std::memory_order_relaxed) + tolerance - half;
+					if (cutoff > 0.0 && target.bvh.AnyWithin(source.Position(s), cutoff*cutoff, hint))
+					{
+						continue;
+					}
+					Interval& interval = open[k];
+					interval.s = s;
+					interval.half = half;
+					interval.d = PointDistance(source, target, s, hint);
+					kept[k] = 1;
+					AtomicMax(best, interval.d);
+				}
+			});
+		double lower = best.load();
+		std::priority_queue<Interval> queue;
+		for (int k = 0; k < source.intervals; k++)
+		{
+			if (kept[k] && open[k].d + open[k].half > lower + tolerance)
+			{
+				queue.push(open[k]);
+			}
+		}
+		int hint = -1;
+		while (!queue.empty() && queue.top().d + queue.top().half > lower + tolerance)
+		{
+			const Interval interval = queue.top();
+			if (interval.half < SPLINE_DISTANCE_MIN_INTERVAL)
+			{
+				// Not resolved within the tolerance: the open intervals
+				// bound the distance
+				return DistanceBound(lower, interval.d + interval.half);
+			}
+			queue.pop();
+			for (int side = -1; side <= 1; side += 2)
+			{
+				Interval child;
+				child.half = 0.5*interval.half;
+				child.s = interval.s + side*child.half;
+				child.d = PointDistance(source, target, child.s, hint);
+				lower = std::max(lower, child.d);
+				if (child.d + child.half > lower + tolerance)
+				{
+					queue.push(child);
+				}
+			}
+		}
+		// Every dropped interval is within lower + tolerance
+		return DistanceBound(lower, lower + tolerance);
+	}
+
+	/*
+	Decide whether the points of the interval are within threshold of the
+	target, by bisection where the Lipschitz bound is not conclusive
+	*/
+	static bool IntervalWithin(const Curve& source, const Curve& target,
+		double s, double half, double threshold, double tolerance, int& hint)
+	{
+		const Vector3 p = source.Position(s);
+		// Every point of the interval is close enough
+		const double cutoff = threshold - half;
+		if (cutoff > 0.0 && target.bvh.AnyWithin(p, cutoff*cutoff, hint))
+		{
+			return true;
+		}
+		double t, d2;
+		const int segment = target.bvh.Closest(p, t, d2, hint);
+		if (segment >= 0)
+		{
+			hint = segment;
+		}
+		const double d = sqrt(d2);
+		if (d > threshold)
+		{
+			return false;
+		}
+		if (half <= tolerance || half < SPLINE_DISTANCE_MIN_INTERVAL)
+		{
+			return true;
+		}
+		return IntervalWithin(source, target, s - 0.5*half, 0.5*half, threshold, tolerance, hint)
+			&& IntervalWithin(source, target, s + 0.5*half, 0.5*half, threshold, tolerance, hint);
+	}
+
+	static bool DirectedWithin(const Curve& source, const Curve& target,
+		double threshold, double tolerance)
+	{
+		if (source.intervals == 0 || target.intervals == 0)
+		{
+			return true;
+		}
+		std::atomic<bool> exceeded(false);
+		tbb::parallel_for(tbb::blocked_range<int>(0, source.intervals),
+			[&](const tbb::blocked_range<int>& range)
+			{
+				int hint = -1;
+				for (int k = range.begin(); k != range.end(); k++)
+				{
+					if (exceeded.load(std::memory_order_relaxed))
+					{
+						return;
+					}
+					if (!IntervalWithin(source, target, (k + 0.5)*source.spacing,
+						0.5*source.spacing, threshold, tolerance, hint))
+					{
+						exceeded.store(true, std::memory_order_relaxed);
+						return;
+					}
+				}
+			});
+		return !exceeded.load();
+	}
+
+public:
+	/**
+	Prepare the queries between two constructed splines, sampled with at
+	most the given arc length spacing
+	*/
+	SplineDistance(CatmullSpline& a, CatmullSpline& b, double spacing):
+		a(a, spacing), b(b, spacing)
+	{
+	}
+
+	/**
+	Directed Hausdorff distance from a to b (max over a of the distance
+	to b), with upper - lower <= tolerance unless intervals shorter than
+	SPLINE_DISTANCE_MIN_INTERVAL would be needed for it
+	*/
+	DistanceBound DirectedHausdorffAB(double tolerance) const
+	{
+		return Directed(a, b, tolerance);
+	}
+
+	/**
+	Directed Hausdorff distance from b to a
+	*/
+	DistanceBound DirectedHausdorffBA(double tolerance) const
+	{
+		return Directed(b, a, tolerance);
+	}
+
+	/**
+	Symmetric Hausdorff distance, bounded as the directed ones
+	*/
+	DistanceBound Hausdorff(double tolerance) const
+	{
+		const DistanceBound ab = Directed(a, b, tolerance);
+		const DistanceBound ba = Directed(b, a, tolerance);
+		return DistanceBound(std::max(ab.lower, ba.lower), std::max(ab.upper, ba.upper));
+	}
+
+	/**
+	True if every point of a is within threshold of b. Returns false as
+	soon as a point farther than threshold is found; points farther by
+	less than tolerance may go unnoticed
+	*/
+	bool DirectedHausdorffWithin(double threshold, double tolerance=1e-3) const
+	{
+		return DirectedWithin(a, b, threshold, tolerance);
+	}
+
+	/**
+	True if the Hausdorff distance of a and b is at most threshold (up to
+	the tolerance)
+	*/
+	bool HausdorffWithin(double threshold, double tolerance=1e-3) const
+	{
+		return DirectedWithin(a, b, threshold, tolerance)
+			&& DirectedWithin(b, a, threshold, tolerance);
+	}
+
+	/**
+	True if the discrete Frechet distance of the samples is at most
+	threshold
+	*/
+	bool DiscreteFrechetWithin(double threshold) const
+	{
+		const std::vector<Vector3>& p = a.samples;
+		const std::vector<Vector3>& q = b.samples;
+		if (p.empty() || q.empty())
+		{
+			return p.empty() && q.empty();
+		}
+		const double eps2 = threshold*threshold;
+		const int n = static_cast<int>(p.size());
+		const int m = static_cast<int>(q.size());
+		if (Distance2(p[0], q[0]) > eps2 || Distance2(p[n - 1], q[m - 1]) > eps2)
+		{
+			return false;
+		}
+		// Reachable cells of the previous and current row, valid on [lo, hi]
+		std::vector<char> prev(m, 0);
+		std::vector<char> cur(m, 0);
+		int prev_lo = 0;
+		int prev_hi = 0;
+		prev[0] = 1;
+		while (prev_hi + 1 < m && Distance2(p[0], q[prev_hi + 1]) <= eps2)
+		{
+			prev[++prev_hi] = 1;
+		}
+		for (int i = 1; i < n; i++)
+		{
+			int lo = -1;
+			int hi = -1;
+			bool left = false;
+			for (int j = prev_lo; j < m; j++)
+			{
+				const bool below = j <= prev_hi && prev[j];
+				const bool diagonal = j > prev_lo && j - 1 <= prev_hi && prev[j - 1];
+				if (!below && !diagonal && !left)
+				{
+					if (j > prev_hi)
+					{
+						break;
+					}
+					cur[j] = 0;
+					continue;
+				}
+				left = Distance2(p[i], q[j]) <= eps2;
+				cur[j] = left;
+				if (left)
+				{
+					lo = lo < 0 ? j : lo;
+					hi = j;
+				}
+			}
+			if (lo < 0)
+			{
+				return false;
+			}
+			std::swap(prev, cur);
+			prev_lo = lo;
+			prev_hi = hi;
+		}
+		return prev_hi == m - 1;
+	}
+
+	/**
+	Discrete Frechet distance of the samples, with upper - lower <= tolerance
+	*/
+	DistanceBound DiscreteFrechet(double tolerance) const
+	{
+		const std::vector<Vector3>& p = a.samples;
+		const std::vector<Vector3>& q = b.samples;
+		if (p.empty() || q.empty())
+		{
+			return DistanceBound();
+		}
+		const int n = static_cast<int>(p.size());
+		const int m = static_cast<int>(q.size());
+		double lower = sqrt(std::max(Distance2(p[0], q[0]), Distance2(p[n - 1], q[m - 1])));
+		// Proportional coupling of the two sequences
+		double upper = Distance2(p[0], q[0]);
+		int i = 0;
+		int j = 0;
+		while (i < n - 1 || j < m - 1)
+		{
+			const double di = static_cast<double>(i + 1)*(m - 1);
+			const double dj = static_cast<double>(j + 1)*(n - 1);
+			if (j == m - 1 || (i < n - 1 && di < dj))
+			{
+				i++;
+			}
+			else if (i == n - 1 || dj < di)
+			{
+				j++;
+			}
+			else
+			{
+				i++;
+				j++;
+			}
+			upper = std::max(upper, Distance2(p[i], q[j]));
+		}
+		upper = sqrt(upper);
+		while (upper - lower > tolerance)
+		{
+			const double mid = 0.5*(lower + upper);
+			if (DiscreteFrechetWithin(mid))
+			{
+				upper = mid;
+			}
+			else
+			{
+				lower = mid;
+			}
+		}
+		return DistanceBound(lower, upper);
+	}
+
+	double GetSpacingA() const
+	{
+		return a.spacing;
+	}
+
+	double GetSpacingB() const
+	{
+		return b.spacing;
+	}
+};
+
+}
+#endif
@@ -0,0 +1,239 @@
+/*
+ * spline_raster.hpp
+ *
+ * Header file for rasterizing Catmull-Rom splines into 2D grids
+ * (occupancy) and computing narrow band distance fields to them
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_SPLINE_RASTER_HPP
+#define CATMULL_ROS_SPLINE_RASTER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+
+#include "catmull.hpp"
+#include "segment_bvh.hpp"
+
+namespace catmull_ros
+{
+
+// Maximal subdivision depth of a segment when rasterizing
+const int RASTER_MAX_DEPTH = 24;
+const int RASTER_DEFAULT_TILE_SIZE = 32;
+
+/**
+ * catmull_ros::GridGeometry
+ *
+ * Row-major grid of width x height square cells in the xy-plane: cell
+ * (ix, iy) covers [x0 + ix*resolution, x0 + (ix + 1)*resolution) x [y0 +
+ * iy*resolution, ...) and is stored at index iy*width + ix
+ */
+struct GridGeometry
+{
+	double origin_x;
+	double origin_y;
+	double resolution;
+	int width;
+	int height;
+
+	GridGeometry(double origin_x, double origin_y, double resolution, int width, int height):
+		origin_x(origin_x), origin_y(origin_y), resolution(resolution), width(width), height(height)
+	{
+	}
+
+	std::size_t Index(int ix, int iy) const
+	{
+		return static_cast<std::size_t>(iy)*width + ix;
+	}
+
+	Vector3 CellCenter(int ix, int iy) const
+	{
+		return Vector3(origin_x + (ix + 0.5)*resolution, origin_y + (iy + 0.5)*resolution, 0.0);
+	}
+
+	/**
+	Cell column of x, clamped to [-1, width] so that far away (or
+	non-finite) coordinates map to the first column outside of the grid
+	*/
+	int CellX(double x) const
+	{
+		return Cell((x - origin_x) / resolution, width);
+	}
+
+	int CellY(double y) const
+	{
+		return Cell((y - origin_y) / resolution, height);
+	}
+
+private:
+	static int Cell(double c, int size)
+	{
+		// Clamped before the conversion, which is undefined out of range
+		return static_cast<int>(std::min(static_cast<double>(size), std::max(-1.0, floor(c))));
+	}
+};
+
+/**
+Set every cell of the grid crossed by the spline to value. Each segment
+is subdivided until the conservative box of a piece is at most one cell
+wide, and the cells overlapping the box are set, so the coverage has no
+gaps (and marks at most 2x2 cells per piece). Pieces outside of the grid
+are not subdivided further. Returns the number of pieces
+*/
+template <typename T>
+int RasterizeSpline(CatmullSpline& spline, const GridGeometry& grid, T* cells, T value)
+{
+	struct Piece
+	{
+		double t0;
+		double t1;
+		int depth;
+	};
+	const double x_max = grid.origin_x + grid.width*grid.resolution;
+	const double y_max = grid.origin_y + grid.height*grid.resolution;
+	int pieces = 0;
+	Piece stack[RASTER_MAX_DEPTH + 2];
+	for (int i = 0; i < spline.GetNumberOfSegments(); i++)
+	{
+		std::shared_ptr<ControlVertex> cv = spline.GetControlVertex(i);
+		int top = 0;
+		// Parameters of the vertex (without the pending knot shift)
+		Piece first = {cv->T(), spline.GetSegmentEndT(i) - spline.GetKnotOffset(i), 0};
+		stack[top++] = first;
+		while (top > 0)
+		{
+			const Piece piece = stack[--top];
+			const BoundingBox box = HermiteSegmentBox(*cv, piece.t0, piece.t1);
+			if (box.max.coords[0] < grid.origin_x || box.min.coords[0] >= x_max
+				|| box.max.coords[1] < grid.origin_y || box.min.coords[1] >= y_max)
+			{
+				continue;
+			}
+			const double extent = std::max(box.max.coords[0] - box.min.coords[0],
+				box.max.coords[1] - box.min.coords[1]);
+			if (extent > grid.resolution && piece.depth < RASTER_MAX_DEPTH)
+			{
+				const double mid = 0.5*(piece.t0 + piece.t1);
+				Piece left = {piece.t0, mid, piece.depth + 1};
+				Piece right = {mid, piece.t1, piece.depth + 1};
+				stack[top++] = right;
+				stack[top++] = left;
+				continue;
+			}
+			pieces++;
+			const int x0 = std::max(0, grid.CellX(box.min.coords[0]));
+			const int x1 = std::min(grid.width - 1, grid.CellX(box.max.coords[0]));
+			const int y0 = std::max(0, grid.CellY(box.min.coords[1]));
+			const int y1 = std::min(grid.height - 1, grid.CellY(box.max.coords[1]));
+			for (int iy = y0; iy <= y1; iy++)
+			{
+				for (int ix = x0; ix <= x1; ix++)
+				{
+					cells[grid.Index(ix, iy)] = value;
+				}
+			}
+		}
+	}
+	return pieces;
+}
+
+/**
+Distance field of the spline at the cell centres (at z = 0), computed by
+exact projection onto the spline through its segment BVH. Only cells
+within band of the spline get their distance, the others get band. With
+is_signed the distance is positive to the left of the spline and negative
+to the right, the far cells taking the side of their own closest point
+(or of the tile centre, in tiles with no segment within band).
+
+The grid is processed in parallel tiles of tile_size x tile_size cells,
+tiles without a segment box within band are filled without any query
+*/
+template <typename T>
+void BuildDistanceField(CatmullSpline& spline, const GridGeometry& grid, double band,
+	bool is_signed, T* field, int tile_size=RASTER_DEFAULT_TILE_SIZE)
+{
+	const SegmentBvh bvh(spline);
+	std::vector<ControlVertex*> segments(spline.GetNumberOfSegments());
+	std::vector<double> offset(segments.size());
+	for (int i = 0; i < static_cast<int>(segments.size()); i++)
+	{
+		segments[i] = spline.GetControlVertex(i).get();
+		offset[i] = spline.GetKnotOffset(i);
+	}
+	const double band2 = band*band;
+	// Side of q relative to the closest point t of the segment
+	auto side = [&](const Vector3& q, int segment, double t)
+	{
+		const Vector3 v = segments[segment]->dhermite(t - offset[segment]);
+		const Vector3 w = q - segments[segment]->Hermite(t - offset[segment]);
+		return v.coords[0]*w.coords[1] - v.coords[1]*w.coords[0] < 0.0 ? -1.0 : 1.0;
+	};
+	tile_size = std::max(1, tile_size);
+	tbb::parallel_for(tbb::blocked_range2d<int>(0, grid.height, tile_size, 0, grid.width, tile_size),
+		[&](const tbb::blocked_range2d<int>& tile)
+		{
+			BoundingBox box;
+			box.Extend(grid.CellCenter(tile.cols().begin(), tile.rows().begin()));
+			box.Extend(grid.CellCenter(tile.cols().end() - 1, tile.rows().end() - 1));
+			std::vector<int> near;
+			bvh.Query(box, band, near);
+			if (near.empty())
+			{
+				// The whole tile is far, on the side of its centre
+				double far_sign = 1.0;
+				if (is_signed)
+				{
+					const Vector3 centre = box.Center();
+					double t, d2;
+					const int segment = bvh.Closest(centre, t, d2);
+					if (segment >= 0)
+					{
+						far_sign = side(centre, segment, t);
+					}
+				}
+				for (int iy = tile.rows().begin(); iy != tile.rows().end(); iy++)
+				{
+					for (int ix = tile.cols().begin(); ix != tile.cols().end(); ix++)
+					{
+						field[grid.Index(ix, iy)] = static_cast<T>(far_sign*band);
+					}
+				}
+				return;
+			}
+			int hint = near.front();
+			for (int iy = tile.rows().begin(); iy != tile.rows().end(); iy++)
+			{
+				for (int ix = tile.cols().begin(); ix != tile.cols().end(); ix++)
+				{
+					const Vector3 q = grid.CellCenter(ix, iy);
+					double t, d2;
+					int segment = bvh.Closest(q, t, d2, hint, band2);
+					double d = band;
+					if (segment >= 0)
+					{
+						hint = segment;
+						d = sqrt(d2);
+					}
+					else if (is_signed)
+					{
+						// Far cell: the side of its own closest point
+						segment = bvh.Closest(q, t, d2, hint);
+					}
+					if (is_signed && segment >= 0)
+					{
+						d *= side(q, segment, t);
+					}
+					field[grid.Index(ix, iy)] = static_cast<T>(d);
+				}
+			}
+		}, tbb::simple_partitioner());
+}
+
+}
+#endif
@@ -0,0 +1,706 @@
+/*
+ * tiled_spline_store.hpp
+ *
+ * Header file for storing large networks of constructed splines in
+ * spatial tiles on disk and querying them through a bounded cache
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_TILED_SPLINE_STORE_HPP
+#define CATMULL_ROS_TILED_SPLINE_STORE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "catmull.hpp"
+#include "hermite_projection.hpp"
+#include "lru_cache.hpp"
+#include "segment_bvh.hpp"
+
+namespace catmull_ros
+{
+
+const std::uint32_t TILED_STORE_MAGIC = 0x54494c45;
+// Tile coordinates are clamped to [-2^30, 2^30]
+const double TILED_STORE_MAX_CELL = 1073741824.0;
+// Largest number of tiles along an axis searched by a closest point query
+const double TILED_STORE_MAX_SEARCH_TILES = 64.0;
+// Largest number of tiles along an axis overlapped by a stored segment
+const std::int32_t TILED_STORE_MAX_SEGMENT_TILES = 4096;
+// Largest number of predicted positions of a prefetch
+const double TILED_STORE_MAX_PREFETCH_STEPS = 256.0;
+
+/**
+ * catmull_ros::TileSegment
+ *
+ * Record of a spline segment in a tile file: the Hermite coefficients on
+ * [t0, t1], r(t) = a[3]*dt^3 + a[2]*dt^2 + a[1]*dt + a[0], dt = t - t0,
+ * and the bounding box of the segment. Files are written in the native
+ * byte order
+ */
+struct TileSegment
+{
+	std::uint32_t spline;
+	std::uint32_t segment;
+	double t0;
+	double t1;
+	double a[4][3];
+	double min[3];
+	double max[3];
+};
+
+/*
+Entry of the per-spline index: the parameter range of a segment and the
+tile holding its record
+*/
+struct TileIndexEntry
+{
+	double t0;
+	double t1;
+	std::int32_t x;
+	std::int32_t y;
+};
+
+struct TileFileHeader
+{
+	std::uint32_t magic;
+	std::uint32_t count;
+	// Closed flag of spline indices, unused for tiles
+	std::uint32_t closed;
+	std::uint32_t reserved;
+};
+
+typedef std::vector<TileSegment> Tile;
+
+/*
+Index of the segments of a stored spline
+*/
+struct TileSplineIndex
+{
+	bool closed;
+	std::vector<TileIndexEntry> segments;
+};
+
+/*
+Tile coordinate of c, clamped (also for infinite or NaN c)
+*/
+inline std::int32_t TileCoordinate(double c, double tile_size)
+{
+	const double cell = floor(c / tile_size);
+	return static_cast<std::int32_t>(std::max(-TILED_STORE_MAX_CELL,
+		std::min(TILED_STORE_MAX_CELL, cell)));
+}
+
+inline std::uint64_t TileKey(std::int32_t x, std::int32_t y)
+{
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32)
+		| static_cast<std::uint32_t>(y);
+}
+
+inline std::string TileFileName(const std::string& directory, std::int32_t x, std::int32_t y)
+{
+	return directory + "/tile_" + std::to_string(x) + "_" + std::to_string(y) + ".bin";
+}
+
+inline std::string TileIndexFileName(const std::string& directory, std::uint32_t spline)
+{
+	return directory + "/spline_" + std::to_string(spline) + ".idx";
+}
+
+/*
+Read the records of a tile or spline index file, false if it does not exist
+*/
+template <typename Record>
+bool ReadTileFile(const std::string& file_name, std::vector<Record>& records, bool* closed=nullptr)
+{
+	records.clear();
+	FILE* file = fopen(file_name.c_str(), "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	TileFileHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == TILED_STORE_MAGIC;
+	if (valid)
+	{
+		records.resize(header.count);
+		valid = header.count == 0
+			|| fread(records.data(), sizeof(Record), header.count, file) == header.count;
+		if (closed != nullptr)
+		{
+			*closed = header.closed != 0;
+		}
+	}
+	fclose(file);
+	if (!valid)
+	{
+		records.clear();
+	}
+	return valid;
+}
+
+template <typename Record>
+bool WriteTileFile(const std::string& file_name, const std::vector<Record>& records, bool closed=false)
+{
+	FILE* file = fopen(file_name.c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	TileFileHeader header;
+	header.magic = TILED_STORE_MAGIC;
+	header.count = static_cast<std::uint32_t>(records.size());
+	header.closed = closed ? 1 : 0;
+	header.reserved = 0;
+	bool valid = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (valid && !records.empty())
+	{
+		valid = fwrite(records.data(), sizeof(Record), records.size(), file) == records.size();
+	}
+	return fclose(file) == 0 && valid;
+}
+
+/*
+Append records to a tile file, creating it if it does not exist
+*/
+template <typename Record>
+bool AppendTileFile(const std::string& file_name, const std::vector<Record>& records)
+{
+	FILE* file = fopen(file_name.c_str(), "r+b");
+	if (file == nullptr)
+	{
+		return WriteTileFile(file_name, records);
+	}
+	TileFileHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == TILED_STORE_MAGIC;
+	if (valid)
+	{
+		valid = fseek(file, sizeof(header) + header.count*sizeof(Record), SEEK_SET) == 0
+			&& fwrite(records.data(), sizeof(Record), records.size(), file) == records.size();
+	}
+	if (valid)
+	{
+		header.count += static_cast<std::uint32_t>(records.size());
+		valid = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	}
+	return fclose(file) == 0 && valid;
+}
+
+inline void EvaluateTileSegment(const TileSegment& s, double t, Vector3& r, Vector3& dr, Vector3& ddr)
+{
+	const double dt = t - s.t0;
+	for (int k = 0; k < 3; k++)
+	{
+		r.coords[k] = s.a[3][k]*(dt*dt*dt) + s.a[2][k]*(dt*dt) + s.a[1][k]*dt + s.a[0][k];
+		dr.coords[k] = 3.0*s.a[3][k]*(dt*dt) + 2.0*s.a[2][k]*dt + s.a[1][k];
+		ddr.coords[k] = 6.0*s.a[3][k]*dt + 2.0*s.a[2][k];
+	}
+}
+
+inline bool TileSegmentLess(const TileSegment& a, const TileSegment& b)
+{
+	return a.spline < b.spline || (a.spline == b.spline && a.segment < b.segment);
+}
+
+/**
+ * catmull_ros::TiledSplineWriter
+ *
+ * Partitions the segments of constructed splines into square tiles of
+ * the xy-plane and writes them into a directory. A segment is stored in
+ * every tile its bounding box overlaps, so queries near a tile border
+ * see it from both sides. Every spline gets an index of its segments.
+ *
+ * Segments are buffered per tile and appended to the tile files when
+ * more than max_buffered are pending, so the writer can stream maps far
+ * larger than its memory. The directory is expected to be empty.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class TiledSplineWriter
+{
+private:
+	std::string directory;
+	double tile_size;
+	std::size_t max_buffered;
+	std::size_t buffered;
+	std::unordered_map<std::uint64_t, Tile> pending;
+
+	bool Flush()
+	{
+		bool success = true;
+		for (std::unordered_map<std::uint64_t, Tile>::iterator it = pending.begin();
+			it != pending.end(); ++it)
+		{
+			const std::int32_t x = static_cast<std::int32_t>(it->first >> 32);
+			const std::int32_t y = static_cast<std::int32_t>(it->first & 0xffffffff);
+			success = AppendTileFile(TileFileName(directory, x, y), it->second) && success;
+		}
+		pending.clear();
+		buffered = 0;
+		return success;
+	}
+public:
+	TiledSplineWriter(const std::string& directory, double tile_size,
+		std::size_t max_buffered=1 << 16):
+		directory(directory), tile_size(tile_size), max_buffered(max_buffered), buffered(0)
+	{
+		mkdir(directory.c_str(), 0755);
+	}
+
+	~TiledSplineWriter()
+	{
+		Finish();
+	}
+
+	/**
+	Store a constructed spline under the id, returns false on I/O errors.
+	A spline with a segment whose bounding box is not finite or overlaps
+	more than TILED_STORE_MAX_SEGMENT_TILES tiles along an axis is refused
+	(false, nothing of it is stored)
+	*/
+	bool AddSpline(std::uint32_t id, CatmullSpline& spline)
+	{
+		const int n = spline.GetNumberOfSegments();
+		std::vector<TileIndexEntry> index(n);
+		std::vector<TileSegment> segments(n);
+		std::vector<std::int32_t> cells(4*n);
+		for (int i = 0; i < n; i++)
+		{
+			std::shared_ptr<ControlVertex> cv = spline.GetControlVertex(i);
+			TileSegment& segment = segments[i];
+			segment.spline = id;
+			segment.segment = i;
+			segment.t0 = spline.GetSegmentStartT(i);
+			segment.t1 = spline.GetSegmentEndT(i);
+			for (int k = 0; k < 3; k++)
+			{
+				segment.a[0][k] = cv->A0().coords[k];
+				segment.a[1][k] = cv->A1().coords[k];
+				segment.a[2][k] = cv->A2().coords[k];
+				segment.a[3][k] = cv->A3().coords[k];
+			}
+			// The vertex is evaluated without the pending knot shift
+			const BoundingBox box = HermiteSegmentBox(*cv, cv->T(),
+				segment.t1 - spline.GetKnotOffset(i));
+			for (int k = 0; k < 3; k++)
+			{
+				segment.min[k] = box.min.coords[k];
+				segment.max[k] = box.max.coords[k];
+			}
+			for (int k = 0; k < 2; k++)
+			{
+				if (!std::isfinite(box.min.coords[k]) || !std::isfinite(box.max.coords[k]))
+				{
+					return false;
+				}
+			}
+			std::int32_t* cell = &cells[4*i];
+			cell[0] = TileCoordinate(box.min.coords[0], tile_size);
+			cell[1] = TileCoordinate(box.max.coords[0], tile_size);
+			cell[2] = TileCoordinate(box.min.coords[1], tile_size);
+			cell[3] = TileCoordinate(box.max.coords[1], tile_size);
+			if (cell[1] - cell[0] >= TILED_STORE_MAX_SEGMENT_TILES
+				|| cell[3] - cell[2] >= TILED_STORE_MAX_SEGMENT_TILES)
+			{
+				return false;
+			}
+			index[i].t0 = segment.t0;
+			index[i].t1 = segment.t1;
+			index[i].x = cell[0];
+			index[i].y = cell[2];
+		}
+		for (int i = 0; i < n; i++)
+		{
+			const std::int32_t* cell = &cells[4*i];
+			for (std::int32_t x = cell[0]; x <= cell[1]; x++)
+			{
+				for (std::int32_t y = cell[2]; y <= cell[3]; y++)
+				{
+					pending[TileKey(x, y)].push_back(segments[i]);
+					buffered++;
+				}
+			}
+		}
+		bool success = WriteTileFile(TileIndexFileName(directory, id), index, spline.IsClosed());
+		if (buffered > max_buffered)
+		{
+			success = Flush() && success;
+		}
+		return success;
+	}
+
+	/**
+	Write the pending segments and the description of the store
+	*/
+	bool Finish()
+	{
+		bool success = Flush();
+		FILE* file = fopen((directory + "/store.meta").c_str(), "w");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		success = fprintf(file, "%.17g\n", tile_size) > 0 && success;
+		return fclose(file) == 0 && success;
+	}
+};
+
+/**
+ * catmull_ros::TiledClosestPoint
+ *
+ * Result of a nearest-segment query of a tiled store
+ */
+struct TiledClosestPoint
+{
+	std::uint32_t spline;
+	std::uint32_t segment;
+	double t;
+	double distance;
+	Vector3 position;
+};
+
+/**
+ * catmull_ros::TiledSplineStore
+ *
+ * Read access to a directory written by TiledSplineWriter. Tiles and
+ * spline indices are loaded on demand into bounded LRU caches, so the
+ * memory use depends on the cache capacities and not on the size of the
+ * map. A loader thread prefetches the tiles ahead of a moving vehicle.
+ *
+ * Evaluation finds the segment through the index of the spline and its
+ * record in the tile holding it. Nearest-segment queries search every
+ * tile within the query radius; as segments are stored in all tiles they
+ * overlap, the results are exact across tile borders.
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class TiledSplineStore
+{
+private:
+	std::string directory;
+	double tile_size;
+	LruCache<std::uint64_t, Tile> tiles;
+	LruCache<std::uint32_t, TileSplineIndex> indices;
+	std::size_t loads;
+
+	std::mutex queue_mutex;
+	std::condition_variable queue_signal;
+	std::deque<std::uint64_t> queue;
+	bool loading;
+	bool running;
+	std::thread loader;
+
+	std::shared_ptr<const Tile> LoadTile(std::uint64_t key)
+	{
+		std::shared_ptr<Tile> tile(new Tile());
+		const std::int32_t x = static_cast<std::int32_t>(key >> 32);
+		const std::int32_t y = static_cast<std::int32_t>(key & 0xffffffff);
+		// Missing tiles are cached empty
+		ReadTileFile(TileFileName(directory, x, y), *tile);
+		std::sort(tile->begin(), tile->end(), TileSegmentLess);
+		std::shared_ptr<const Tile> result = tile;
+		tiles.Put(key, result);
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		loads++;
+		return result;
+	}
+
+	void LoaderLoop()
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		while (true)
+		{
+			queue_signal.wait(lock, [this]() { return !running || !queue.empty(); });
+			if (!running)
+			{
+				return;
+			}
+			const std::uint64_t key = queue.front();
+			queue.pop_front();
+			loading = true;
+			lock.unlock();
+			if (!tiles.Contains(key))
+			{
+				LoadTile(key);
+			}
+			lock.lock();
+			loading = false;
+			queue_signal.notify_all();
+		}
+	}
+
+	std::int32_t Cell(double c) const
+	{
+		return TileCoordinate(c, tile_size);
+	}
+
+	void Enqueue(std::uint64_t key)
+	{
+		if (std::find(queue.begin(), queue.end(), key) == queue.end())
+		{
+			queue.push_back(key);
+		}
+	}
+
+public:
+	/**
+	Open a store keeping at most max_tiles tiles and max_indices spline
+	indices in memory
+	*/
+	TiledSplineStore(const std::string& directory, std::size_t max_tiles,
+		std::size_t max_indices=256):
+		directory(directory), tile_size(0.0), tiles(max_tiles), indices(max_indices), loads(0), loading(false), running(true)
+	{
+		FILE* file = fopen((directory + "/store.meta").c_str(), "r");
+		if (file != nullptr)
+		{
+			if (fscanf(file, "%lf", &tile_size) != 1 || std::isinf(tile_size))
+			{
+				tile_size = 0.0;
+			}
+			fclose(file);
+		}
+		loader = std::thread(&TiledSplineStore::LoaderLoop, this);
+	}
+
+	~TiledSplineStore()
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			running = false;
+		}
+		queue_signal.notify_all();
+		loader.join();
+	}
+
+	bool IsOpen() const
+	{
+		return tile_size > 0.0;
+	}
+
+	double GetTileSize() const
+	{
+		return tile_size;
+	}
+
+	/**
+	Tile at the integer tile coordinates, loaded if it is not cached
+	*/
+	std::shared_ptr<const Tile> GetTile(std::int32_t x, std::int32_t y)
+	{
+		const std::uint64_t key = TileKey(x, y);
+		std::shared_ptr<const Tile> tile = tiles.Get(key);
+		if (tile == nullptr)
+		{
+			tile = LoadTile(key);
+		}
+		return tile;
+	}
+
+	/**
+	Index of the segments of a spline, nullptr if it is not in the store
+	*/
+	std::shared_ptr<const TileSplineIndex> GetSplineIndex(std::uint32_t spline)
+	{
+		std::shared_ptr<const TileSplineIndex> index = indices.Get(spline);
+		if (index == nullptr)
+		{
+			std::shared_ptr<TileSplineIndex> loaded(new TileSplineIndex());
+			if (!ReadTileFile(TileIndexFileName(directory, spline), loaded->segments,
+				&loaded->closed))
+			{
+				return std::shared_ptr<const TileSplineIndex>();
+			}
+			index = loaded;
+			indices.Put(spline, index);
+		}
+		return index;
+	}
+
+	/**
+	Evaluate position, velocity and acceleration of a spline at parameter
+	t. Returns false (and zero vectors) if the spline is not in the store
+	or t is outside of its parameter range
+	*/
+	bool Evaluate(std::uint32_t spline, double t, Vector3& r, Vector3& dr, Vector3& ddr)
+	{
+		r = Vector3();
+		dr = Vector3();
+		ddr = Vector3();
+		std::shared_ptr<const TileSplineIndex> index = GetSplineIndex(spline);
+		if (index == nullptr || index->segments.empty() || t < index->segments.front().t0)
+		{
+			return false;
+		}
+		const std::vector<TileIndexEntry>& segments = index->segments;
+		if (t > segments.back().t1 || (t == segments.back().t1 && index->closed))
+		{
+			return false;
+		}
+		int lo = 0;
+		int hi = static_cast<int>(segments.size()) - 1;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi + 1) / 2;
+			if (segments[mid].t0 <= t)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid - 1;
+			}
+		}
+		std::shared_ptr<const Tile> tile = GetTile(segments[lo].x, segments[lo].y);
+		TileSegment key;
+		key.spline = spline;
+		key.segment = lo;
+		Tile::const_iterator it = std::lower_bound(tile->begin(), tile->end(), key, TileSegmentLess);
+		if (it == tile->end() || it->spline != spline || it->segment != static_cast<std::uint32_t>(lo))
+		{
+			return false;
+		}
+		EvaluateTileSegment(*it, t, r, dr, ddr);
+		return true;
+	}
+
+	/**
+	Closest point of the stored splines to q within max_distance (in
+	3D, tiles are searched by the xy-distance). Returns false if there is
+	no segment within max_distance. The search covers at most
+	TILED_STORE_MAX_SEARCH_TILES tiles along an axis, a larger (or
+	infinite) max_distance is reduced to that
+	*/
+	bool Closest(const Vector3& q, double max_distance, TiledClosestPoint& result)
+	{
+		if (!IsOpen() || !(max_distance >= 0.0))
+		{
+			return false;
+		}
+		max_distance = std::min(max_distance, 0.5*TILED_STORE_MAX_SEARCH_TILES*tile_size);
+		double best_d2 = max_distance*max_distance;
+		bool found = false;
+		const std::int32_t x0 = Cell(q.coords[0] - max_distance);
+		const std::int32_t x1 = Cell(q.coords[0] + max_distance);
+		const std::int32_t y0 = Cell(q.coords[1] - max_distance);
+		const std::int32_t y1 = Cell(q.coords[1] + max_distance);
+		for (std::int32_t x = x0; x <= x1; x++)
+		{
+			for (std::int32_t y = y0; y <= y1; y++)
+			{
+				std::shared_ptr<const Tile> tile = GetTile(x, y);
+				for (Tile::const_iterator it = tile->begin(); it != tile->end(); ++it)
+				{
+					BoundingBox box;
+					box.Extend(Vector3(it->min[0], it->min[1], it->min[2]));
+					box.Extend(Vector3(it->max[0], it->max[1], it->max[2]));
+					if (box.SquaredDistance(q) >= best_d2)
+					{
+						continue;
+					}
+					const Vector3 a0(it->a[0][0], it->a[0][1], it->a[0][2]);
+					const Vector3 a1(it->a[1][0], it->a[1][1], it->a[1][2]);
+					const Vector3 a2(it->a[2][0], it->a[2][1], it->a[2][2]);
+					const Vector3 a3(it->a[3][0], it->a[3][1], it->a[3][2]);
+					const double dt = ClosestHermiteParameter(a0, a1, a2, a3, it->t1 - it->t0, q);
+					const Vector3 p = a3*(dt*dt*dt) + a2*(dt*dt) + a1*dt + a0;
+					const double d2 = Dot(p - q, p - q);
+					if (d2 < best_d2)
+					{
+						best_d2 = d2;
+						found = true;
+						result.spline = it->spline;
+						result.segment = it->segment;
+						result.t = it->t0 + dt;
+						result.distance = sqrt(d2);
+						result.position = p;
+					}
+				}
+			}
+		}
+		return found;
+	}
+
+	/**
+	Queue the tiles around the predicted positions position + velocity*s
+	for s in [0, horizon] for the loader thread (at most
+	TILED_STORE_MAX_PREFETCH_STEPS positions)
+	*/
+	void Prefetch(const Vector3& position, const Vector3& velocity, double horizon)
+	{
+		if (!IsOpen() || !(horizon >= 0.0) || std::isinf(horizon))
+		{
+			return;
+		}
+		const double speed = sqrt(velocity.coords[0]*velocity.coords[0]
+			+ velocity.coords[1]*velocity.coords[1]);
+		const double distance_steps = ceil(2.0*speed*horizon / tile_size);
+		// Also caps an infinite or NaN speed
+		const int steps = 1 + static_cast<int>(distance_steps < TILED_STORE_MAX_PREFETCH_STEPS
+			? distance_steps : TILED_STORE_MAX_PREFETCH_STEPS);
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		for (int i = 0; i <= steps; i++)
+		{
+			const double s = horizon*i / steps;
+			const std::int32_t cx = Cell(position.coords[0] + velocity.coords[0]*s);
+			const std::int32_t cy = Cell(position.coords[1] + velocity.coords[1]*s);
+			// The tile of the prediction and its neighbours
+			for (std::int32_t x = cx - 1; x <= cx + 1; x++)
+			{
+				for (std::int32_t y = cy - 1; y <= cy + 1; y++)
+				{
+					if (!tiles.Contains(TileKey(x, y)))
+					{
+						Enqueue(TileKey(x, y));
+					}
+				}
+			}
+		}
+		queue_signal.notify_all();
+	}
+
+	/**
+	Block until the loader thread has processed the queued tiles
+	*/
+	void WaitForPrefetch()
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		queue_signal.wait(lock, [this]() { return queue.empty() && !loading; });
+	}
+
+	bool IsTileCached(std::int32_t x, std::int32_t y) const
+	{
+		return tiles.Contains(TileKey(x, y));
+	}
+
+	std::size_t GetNumberOfCachedTiles() const
+	{
+		return tiles.Size();
+	}
+
+	/**
+	Number of tiles read from disk so far
+	*/
+	std::size_t GetNumberOfLoads()
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		return loads;
+	}
+};
+
+}
+#endif
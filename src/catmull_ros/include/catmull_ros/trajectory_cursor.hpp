@@ -0,0 +1,399 @@
+/*
+ * trajectory_cursor.hpp
+ *
+ * Header file for a stateful cursor following a Catmull-Rom spline
+ * with incremental advance
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+#ifndef CATMULL_ROS_TRAJECTORY_CURSOR_HPP
+#define CATMULL_ROS_TRAJECTORY_CURSOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+
+#include "catmull.hpp"
+
+namespace catmull_ros
+{
+
+/**
+ * catmull_ros::SplineCursor
+ *
+ * Position on a constructed spline remembering its current segment
+ * and the local Hermite coefficients, so that advancing it by a small
+ * step costs O(1) instead of a search from the first control vertex:
+ * - Advance(dt) moves by parameter, crossing into the neighbouring
+ *   segment (or wrapping around a closed spline) in O(1)
+ * - AdvanceArcLength(ds) moves by arc length using the local derivatives
+ * - SetStep(dt) and Step() advance by a fixed step with forward
+ *   differences: three vector additions per step
+ *
+ * Hajdu Csaba (kyberszittya)
+ */
+class SplineCursor
+{
+private:
+	CatmullSpline* spline;
+	int segment;
+	int segments;
+	bool closed;
+	bool at_end;
+	// Segment bounds and local parameter
+	double t0;
+	double t1;
+	double dt;
+	Vector3 a0;
+	Vector3 a1;
+	Vector3 a2;
+	Vector3 a3;
+	// Forward differences of the position for the fixed step
+	double step;
+	bool stepping;
+	Vector3 f0;
+	Vector3 f1;
+	Vector3 f2;
+	Vector3 f3;
+
+	void LoadSegment(int i)
+	{
+		segment = i;
+		std::shared_ptr<ControlVertex> cv = spline->GetControlVertex(i);
+		t0 = spline->GetSegmentStartT(i);
+		t1 = spline->GetSegmentEndT(i);
+		a0 = cv->A0();
+		a1 = cv->A1();
+		a2 = cv->A2();
+		a3 = cv->A3();
+		stepping = false;
+	}
+
+	Vector3 Horner(double x) const
+	{
+		return ((a3*x + a2)*x + a1)*x + a0;
+	}
+
+	void InitDifferences()
+	{
+		const Vector3 p0 = Horner(dt);
+		const Vector3 p1 = Horner(dt + step);
+		const Vector3 p2 = Horner(dt + 2.0*step);
+		const Vector3 p3 = Horner(dt + 3.0*step);
+		f0 = p0;
+		f1 = p1 - p0;
+		f2 = p2 - 2.0*p1 + p0;
+		f3 = p3 - 3.0*p2 + 3.0*p1 - p0;
+		stepping = true;
+	}
+
+public:
+	/**
+	Place the cursor at the beginning of the (constructed) spline
+	*/
+	explicit SplineCursor(CatmullSpline& spline):
+		spline(&spline), segment(0), at_end(false),
+		t0(0.0), t1(0.0), dt(0.0), step(0.0), stepping(false)
+	{
+		segments = spline.GetNumberOfSegments();
+		closed = spline.IsClosed();
+		if (segments > 0)
+		{
+			LoadSegment(0);
+		}
+		else
+		{
+			at_end = true;
+		}
+	}
+
+	/**
+	Place the cursor at parameter t (binary search), clamped to the range
+	*/
+	void Seek(double t)
+	{
+		if (segments == 0)
+		{
+			return;
+		}
+		int i = spline->FindSegment(t);
+		if (i < 0)
+		{
+			i = t < spline->GetSegmentStartT(0) ? 0 : segments - 1;
+		}
+		LoadSegment(i);
+		dt = std::max(0.0, std::min(t1 - t0, t - t0));
+		at_end = !closed && i == segments - 1 && dt == t1 - t0;
+	}
+
+	/**
+	Advance by delta (which may be negative) in the parameter.
+	Returns false once the end of an open spline has been reached
+	*/
+	bool Advance(double delta)
+	{
+		if (segments == 0)
+		{
+			return false;
+		}
+		dt += delta;
+		at_end = false;
+		while (dt >= t1 - t0)
+		{
+			if (segment + 1 < segments)
+			{
+				const double length = t1 - t0;
+				LoadSegment(segment + 1);
+				dt -= length;
+			}
+			else if (closed)
+			{
+				const double length = t1 - t0;
+				LoadSegment(0);
+				dt -= length;
+			}
+			else
+			{
+				dt = t1 - t0;
+				at_end = true;
+				stepping = false;
+				return false;
+			}
+		}
+		while (dt < 0.0)
+		{
+			if (segment > 0)
+			{
+				LoadSegment(segment - 1);
+				dt += t1 - t0;
+			}
+			else if (closed)
+			{
+				LoadSegment(segments - 1);
+				dt += t1 - t0;
+			}
+			else
+			{
+				dt = 0.0;
+				stepping = false;
+				return false;
+			}
+		}
+		stepping = false;
+		return true;
+	}
+
+	/**
+	Advance by the arc length ds >= 0: the parameter step comes from the
+	second-order expansion of the arc length, corrected by one Newton step
+	against the Simpson estimate of the travelled distance
+	*/
+	bool AdvanceArcLength(double ds)
+	{
+		const Vector3 v = Velocity();
+		const double speed = v.coords[0]*v.coords[0] + v.coords[1]*v.coords[1]
+			+ v.coords[2]*v.coords[2];
+		if (speed <= 0.0 || ds <= 0.0)
+		{
+			return !at_end;
+		}
+		const double vn = sqrt(speed);
+		const double dspeed = Dot(v, Acceleration()) / vn;
+		double delta = ds / vn - dspeed*ds*ds / (2.0*vn*vn*vn);
+		if (delta <= 0.0)
+		{
+			delta = ds / vn;
+		}
+		SplineCursor mid(*this);
+		mid.Advance(0.5*delta);
+		SplineCursor end(*this);
+		end.Advance(delta);
+		const Vector3 vm = mid.Velocity();
+		const Vector3 ve = end.Velocity();
+		const double travelled = delta / 6.0 *
+			(vn + 4.0*sqrt(Dot(vm, vm)) + sqrt(Dot(ve, ve)));
+		const double ve_n = sqrt(Dot(ve, ve));
+		if (ve_n > 0.0)
+		{
+			delta += (ds - travelled) / ve_n;
+		}
+		return Advance(delta);
+	}
+
+	/**
+	Set the fixed step used by Step()
+	*/
+	void SetStep(double delta)
+	{
+		step = delta;
+		stepping = false;
+	}
+
+	/**
+	Advance by the fixed step with forward differencing; falls back to
+	Advance() (and restarts the differences) when leaving the segment
+	*/
+	bool Step()
+	{
+		if (segments == 0)
+		{
+			return false;
+		}
+		if (!stepping)
+		{
+			InitDifferences();
+		}
+		if (dt + step < t1 - t0 && dt + step >= 0.0)
+		{
+			dt += step;
+			f0 += f1;
+			f1 += f2;
+			f2 += f3;
+			return true;
+		}
+		return Advance(step);
+	}
+
+	Vector3 Position() const
+	{
+		if (stepping)
+		{
+			return f0;
+		}
+		return Horner(dt);
+	}
+
+	Vector3 Velocity() const
+	{
+		return (3.0*a3*dt + 2.0*a2)*dt + a1;
+	}
+
+	Vector3 Acceleration() const
+	{
+		return 6.0*a3*dt + 2.0*a2;
+	}
+
+	double T() const
+	{
+		return t0 + dt;
+	}
+
+	int Segment() const
+	{
+		return segment;
+	}
+
+	/**
+	True if the cursor stands at the end of an open spline
+	*/
+	bool AtEnd() const
+	{
+		return at_end;
+	}
+};
+
+/**
+ * catmull_ros::SplineSampleIterator
+ *
+ * Forward iterator over uniformly spaced positions of a spline
+ */
+class SplineSampleIterator
+{
+public:
+	typedef std::input_iterator_tag iterator_category;
+	typedef Vector3 value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const Vector3* pointer;
+	typedef const Vector3& reference;
+private:
+	SplineCursor cursor;
+	int remaining;
+	Vector3 current;
+public:
+	SplineSampleIterator(const SplineCursor& cursor, int remaining):
+		cursor(cursor), remaining(remaining)
+	{
+		current = this->cursor.Position();
+	}
+
+	const Vector3& operator*() const
+	{
+		return current;
+	}
+
+	const Vector3* operator->() const
+	{
+		return &current;
+	}
+
+	SplineSampleIterator& operator++()
+	{
+		remaining--;
+		if (remaining > 0)
+		{
+			cursor.Step();
+			current = cursor.Position();
+		}
+		return *this;
+	}
+
+	bool operator==(const SplineSampleIterator& rhs) const
+	{
+		return remaining == rhs.remaining;
+	}
+
+	bool operator!=(const SplineSampleIterator& rhs) const
+	{
+		return remaining != rhs.remaining;
+	}
+};
+
+/**
+ * catmull_ros::SplineSamples
+ *
+ * Range of positions sampled with a fixed parameter step, for range-for:
+ *   for (const Vector3& p : SplineSamples(spline, 0.1)) { ... }
+ * An open spline is sampled from its first knot up to its end,
+ * a closed one over a single loop
+ */
+class SplineSamples
+{
+private:
+	SplineCursor start;
+	int count;
+public:
+	SplineSamples(CatmullSpline& spline, double step): start(spline), count(0)
+	{
+		const int segments = spline.GetNumberOfSegments();
+		if (segments > 0 && step > 0.0)
+		{
+			const double range = spline.GetSegmentEndT(segments - 1)
+				- spline.GetSegmentStartT(0);
+			count = static_cast<int>(floor(range / step));
+			if (!spline.IsClosed() || count*step < range)
+			{
+				count++;
+			}
+		}
+		start.SetStep(step);
+	}
+
+	int Size() const
+	{
+		return count;
+	}
+
+	SplineSampleIterator begin() const
+	{
+		return SplineSampleIterator(start, count);
+	}
+
+	SplineSampleIterator end() const
+	{
+		return SplineSampleIterator(start, 0);
+	}
+};
+
+}
+#endif
@@ -8,6 +8,9 @@
 #ifndef CATMULL_ROS_VECTOR3_HPP
 #define CATMULL_ROS_VECTOR3_HPP
 
+#include <cmath>
+#include <type_traits>
+
 namespace catmull_ros {
 
 /**
@@ -15,6 +18,10 @@ namespace catmull_ros {
  * 
  * Simple-purpose 3D vector suitable for all platforms (even for uCs)
  * Some polishing might be required though.
+ *
+ * The layout is exactly three packed doubles (x, y, z) without padding,
+ * so an array of n vectors is a row-major n x 3 array of doubles, which
+ * other libraries (e.g. Eigen, see eigen_interop.hpp) can map in place.
  * 
  * Hajdu Csaba (kyberszittya)
  */
@@ -152,5 +159,38 @@ inline Vector3 operator/(const Vector3& lhs, const double& rhs)
 	return res;
 }
 
+/**
+Scalar (dot) product of two vectors
+*/
+inline double Dot(const Vector3& lhs, const Vector3& rhs)
+{
+	return lhs.coords[0]*rhs.coords[0]
+		+ lhs.coords[1]*rhs.coords[1]
+		+ lhs.coords[2]*rhs.coords[2];
+}
+
+/**
+Vector (cross) product of two vectors
+*/
+inline Vector3 Cross(const Vector3& lhs, const Vector3& rhs)
+{
+	return Vector3(
+		lhs.coords[1]*rhs.coords[2] - lhs.coords[2]*rhs.coords[1],
+		lhs.coords[2]*rhs.coords[0] - lhs.coords[0]*rhs.coords[2],
+		lhs.coords[0]*rhs.coords[1] - lhs.coords[1]*rhs.coords[0]);
+}
+
+/**
+Euclidean distance of two points
+*/
+inline double Distance(const Vector3& lhs, const Vector3& rhs)
+{
+	const Vector3 d = lhs - rhs;
+	return sqrt(Dot(d, d));
+}
+
+static_assert(sizeof(Vector3) == 3*sizeof(double), "Vector3 must be three packed doubles");
+static_assert(std::is_standard_layout<Vector3>::value, "Vector3 must have standard layout");
+
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,72 @@
+/**
+ * Benchmark of the lookup table evaluation against the exact evaluation
+ *
+*/
+#include "../include/catmull_ros/lookup_table.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+static void BuildPath(CatmullSpline& cspline, int vertices)
+{
+    for (int i = 0; i < vertices; i++)
+    {
+        cspline.AddControlVertex(Vector3(3.0*i, 8.0*sin(0.2*i), 0.5*cos(0.1*i)));
+    }
+    cspline.Construct();
+}
+
+TEST(LookupTableBenchmark, AgainstExactEvaluation)
+{
+    CatmullSpline cspline;
+    BuildPath(cspline, 2000);
+    SplineLookupTable linear(cspline, 0.01, LOOKUP_LINEAR);
+    SplineLookupTable quadratic(cspline, 0.01, LOOKUP_QUADRATIC);
+    const int n = 1000000;
+    std::vector<double> t(n);
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(cspline.GetMinT(), cspline.GetMaxT());
+    for (int i = 0; i < n; i++)
+    {
+        t[i] = distribution(generator);
+    }
+    double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        sink += cspline.r(t[i]).coords[0];
+    }
+    const double exact = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / n;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        sink += linear.r(t[i]).coords[0];
+    }
+    const double table_linear = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / n;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        sink += quadratic.r(t[i]).coords[0];
+    }
+    const double table_quadratic = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / n;
+    std::cout << "r(t) per query: exact " << exact << " ns, linear table " << table_linear
+        << " ns (" << linear.GetNumberOfNodes() << " nodes, error <= " << linear.GetErrorBound()
+        << "), quadratic table " << table_quadratic << " ns (" << quadratic.GetNumberOfNodes()
+        << " nodes, error <= " << quadratic.GetErrorBound() << ")" << std::endl;
+    ASSERT_NE(0.0, sink);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
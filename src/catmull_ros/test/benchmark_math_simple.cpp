@@ -0,0 +1,156 @@
+/**
+ * Benchmarks of the batch math kernels against the scalar loops
+ *
+*/
+#include "../include/catmull_ros/math_simple.hpp"
+#include "../include/catmull_ros/math_simple_batch.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace ros_math_simple;
+
+const std::size_t BENCHMARK_SIZE = 1 << 20;
+const int BENCHMARK_REPEAT = 20;
+
+static std::vector<double> BenchmarkInput()
+{
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> uniform(-10.0, 10.0);
+    std::vector<double> values(BENCHMARK_SIZE);
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        values[i] = uniform(generator);
+    }
+    return values;
+}
+
+template<typename F>
+static double MeasureNanosPerElement(F f, std::size_t elements=BENCHMARK_SIZE)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCHMARK_REPEAT; r++)
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count()
+        / (static_cast<double>(BENCHMARK_REPEAT) * elements);
+}
+
+/*
+The batch kernels are bit-identical to the scalar functions
+*/
+static void AssertSameResults(const std::vector<double>& expected, const std::vector<double>& out)
+{
+    ASSERT_EQ(expected.size(), out.size());
+    for (std::size_t i = 0; i < out.size(); i++)
+    {
+        ASSERT_EQ(expected[i], out[i]) << i;
+    }
+}
+
+static void Report(const char* name, double scalar, double batch)
+{
+    std::cout << name << ": scalar " << scalar << " ns/elem, batch "
+        << batch << " ns/elem (simd: " << has_simd() << ")" << std::endl;
+}
+
+TEST(MathSimpleBenchmark, clamp)
+{
+    std::vector<double> in = BenchmarkInput();
+    std::vector<double> expected(in.size());
+    std::vector<double> out(in.size());
+    const double scalar = MeasureNanosPerElement([&]()
+    {
+        for (std::size_t i = 0; i < in.size(); i++)
+        {
+            expected[i] = clamp(in[i], -1.0, 1.0);
+        }
+    });
+    const double batch = MeasureNanosPerElement([&]()
+    {
+        clamp_array(in.data(), out.data(), in.size(), -1.0, 1.0);
+    });
+    Report("clamp", scalar, batch);
+    AssertSameResults(expected, out);
+}
+
+TEST(MathSimpleBenchmark, smoothstep)
+{
+    std::vector<double> in = BenchmarkInput();
+    std::vector<double> expected(in.size());
+    std::vector<double> out(in.size());
+    const double scalar = MeasureNanosPerElement([&]()
+    {
+        for (std::size_t i = 0; i < in.size(); i++)
+        {
+            expected[i] = smoothstep(-5.0, 5.0, in[i]);
+        }
+    });
+    const double batch = MeasureNanosPerElement([&]()
+    {
+        smoothstep_array(-5.0, 5.0, in.data(), out.data(), in.size());
+    });
+    Report("smoothstep", scalar, batch);
+    AssertSameResults(expected, out);
+}
+
+TEST(MathSimpleBenchmark, wrapAngle)
+{
+    std::vector<double> in = BenchmarkInput();
+    std::vector<double> expected(in.size());
+    std::vector<double> out(in.size());
+    const double scalar = MeasureNanosPerElement([&]()
+    {
+        for (std::size_t i = 0; i < in.size(); i++)
+        {
+            expected[i] = wrap_angle(in[i]);
+        }
+    });
+    const double batch = MeasureNanosPerElement([&]()
+    {
+        wrap_angle_array(in.data(), out.data(), in.size());
+    });
+    Report("wrap_angle", scalar, batch);
+    AssertSameResults(expected, out);
+}
+
+TEST(MathSimpleBenchmark, normalize)
+{
+    std::vector<double> in = BenchmarkInput();
+    std::vector<catmull_ros::Vector3> v(in.size() / 3);
+    for (std::size_t i = 0; i < v.size(); i++)
+    {
+        v[i] = catmull_ros::Vector3(in[3*i], in[3*i + 1], in[3*i + 2]);
+    }
+    std::vector<catmull_ros::Vector3> expected(v);
+    const double scalar = MeasureNanosPerElement([&]()
+    {
+        for (std::size_t i = 0; i < expected.size(); i++)
+        {
+            normalize_scalar(expected[i]);
+        }
+    }, v.size());
+    const double batch = MeasureNanosPerElement([&]()
+    {
+        normalize_array(v.data(), v.size());
+    }, v.size());
+    Report("normalize", scalar, batch);
+    for (std::size_t i = 0; i < v.size(); i++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            ASSERT_EQ(expected[i].coords[k], v[i].coords[k]) << i;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
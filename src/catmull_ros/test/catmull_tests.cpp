@@ -3,6 +3,9 @@
 */
 #include "../include/catmull_ros/catmull.hpp"
 
+#include <cmath>
+#include <list>
+#include <vector>
 #include <gtest/gtest.h>
 
 using namespace catmull_ros;
@@ -115,6 +118,256 @@ TEST(CatmullRomBasic, FourPointFunction)
     ASSERT_DOUBLE_EQ(0.0, cspline.r(0).Z());    
 }
 
+static std::vector<Vector3> WavePoints(std::size_t n)
+{
+    std::vector<Vector3> points(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        points[i] = Vector3(0.5*i, sin(0.01*i), 0.001*i);
+    }
+    return points;
+}
+
+TEST(CatmullRomBulkLoad, MatchesSingleVertices)
+{
+    std::vector<Vector3> points = WavePoints(200);
+    CatmullSpline single;
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        single.AddControlVertex(points[i]);
+    }
+    single.Construct();
+    CatmullSpline bulk;
+    bulk.AddControlVertices(points.data(), 50);
+    bulk.AddControlVertices(points.begin() + 50, points.end());
+    bulk.Construct();
+    ASSERT_EQ(200, bulk.GetNumberOfControlVertices());
+    for (double t = 0.0; t < single.GetMaxT(); t += 0.7)
+    {
+        ASSERT_EQ(single.r(t).coords[1], bulk.r(t).coords[1]);
+        ASSERT_EQ(single.dr(t).coords[0], bulk.dr(t).coords[0]);
+    }
+}
+
+TEST(CatmullRomBulkLoad, ForwardIteratorsAndKnots)
+{
+    std::list<Vector3> points;
+    std::vector<double> knots;
+    for (int i = 0; i < 5; i++)
+    {
+        points.push_back(Vector3(1.0*i, 0.0, 0.0));
+        knots.push_back(2.0*i);
+    }
+    CatmullSpline cspline;
+    cspline.AddControlVertices(points.begin(), points.end(), knots.begin());
+    ASSERT_EQ(5, cspline.GetNumberOfControlVertices());
+    ASSERT_DOUBLE_EQ(6.0, cspline.GetControlVertex(3)->T());
+    ASSERT_DOUBLE_EQ(3.0, cspline.GetControlVertex(3)->P().X());
+    cspline.Construct();
+    ASSERT_DOUBLE_EQ(2.5, cspline.r(2.5).X());
+}
+
+TEST(CatmullRomBulkLoad, ParallelLoadMatchesSingleAdds)
+{
+    // Large enough for the parallel allocation path
+    const std::size_t n = 2*CATMULL_PARALLEL_LOAD_THRESHOLD + 3;
+    std::vector<Vector3> points = WavePoints(n);
+    CatmullSpline single;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        single.AddControlVertex(points[i]);
+    }
+    CatmullSpline bulk;
+    bulk.AddControlVertices(points);
+    ASSERT_EQ(static_cast<int>(n), bulk.GetNumberOfControlVertices());
+    bulk.Construct();
+    single.Construct();
+    ASSERT_EQ(single.GetMaxT(), bulk.GetMaxT());
+    for (std::size_t i = 0; i < n; i += 997)
+    {
+        ASSERT_EQ(single.GetControlVertex(i)->T(), bulk.GetControlVertex(i)->T());
+        const Vector3 p = bulk.GetControlVertex(i)->P();
+        for (int k = 0; k < 3; k++)
+        {
+            ASSERT_EQ(points[i].coords[k], p.coords[k]);
+        }
+    }
+}
+
+static void ExpectSameSpline(CatmullSpline& expected, CatmullSpline& edited)
+{
+    ASSERT_EQ(expected.GetNumberOfControlVertices(), edited.GetNumberOfControlVertices());
+    ASSERT_NEAR(expected.GetMinT(), edited.GetMinT(), 1e-9);
+    ASSERT_NEAR(expected.GetMaxT(), edited.GetMaxT(), 1e-9);
+    for (double t = 0.0; t < expected.GetMaxT(); t += 0.13)
+    {
+        ASSERT_LT((expected.r(t) - edited.r(t)).GetNorm(), 1e-8) << t;
+        ASSERT_LT((expected.dr(t) - edited.dr(t)).GetNorm(), 1e-8) << t;
+        ASSERT_LT((expected.ddr(t) - edited.ddr(t)).GetNorm(), 1e-7) << t;
+    }
+}
+
+static void BuildFrom(CatmullSpline& cspline, const std::vector<Vector3>& points, bool loop)
+{
+    cspline.AddControlVertices(points);
+    if (loop)
+    {
+        cspline.ConstructLoop();
+    }
+    else
+    {
+        cspline.Construct();
+    }
+}
+
+TEST(CatmullRomEdit, MoveInsertRemoveMatchConstruct)
+{
+    for (int loop = 0; loop < 2; loop++)
+    {
+        std::vector<Vector3> points = WavePoints(30);
+        CatmullSpline edited;
+        BuildFrom(edited, points, loop == 1);
+        const int moves[] = {0, 1, 14, 28, 29};
+        for (int k = 0; k < 5; k++)
+        {
+            points[moves[k]] = points[moves[k]] + Vector3(0.3, -0.2, 0.1);
+            edited.MoveControlVertex(moves[k], points[moves[k]]);
+        }
+        const int inserts[] = {0, 10, 32};
+        for (int k = 0; k < 3; k++)
+        {
+            const Vector3 p(0.5*inserts[k] - 0.25, 1.0, 0.0);
+            points.insert(points.begin() + inserts[k], p);
+            edited.InsertControlVertex(inserts[k], p);
+        }
+        const int removes[] = {0, 5, 30, 20};
+        for (int k = 0; k < 4; k++)
+        {
+            points.erase(points.begin() + removes[k]);
+            edited.RemoveControlVertex(removes[k]);
+        }
+        CatmullSpline expected;
+        BuildFrom(expected, points, loop == 1);
+        ExpectSameSpline(expected, edited);
+        for (int i = 0; i < expected.GetNumberOfControlVertices(); i++)
+        {
+            ASSERT_NEAR(expected.GetSegmentStartT(i), edited.GetSegmentStartT(i), 1e-9);
+        }
+        // Applying the lazy knot shifts does not change the spline
+        edited.ApplyKnotShifts();
+        ExpectSameSpline(expected, edited);
+        for (int i = 0; i < expected.GetNumberOfControlVertices(); i++)
+        {
+            ASSERT_NEAR(expected.GetControlVertex(i)->T(), edited.GetControlVertex(i)->T(), 1e-9);
+        }
+    }
+}
+
+TEST(CatmullRomEdit, ManyPendingShiftsMatchConstruct)
+{
+    std::vector<Vector3> points = WavePoints(200);
+    CatmullSpline edited;
+    BuildFrom(edited, points, false);
+    // More edits than pending shifts are kept, in no particular order
+    for (int k = 0; k < 90; k++)
+    {
+        const int i = 2 + (k*37) % 190;
+        if (k % 3 == 2)
+        {
+            points.erase(points.begin() + i);
+            edited.RemoveControlVertex(i);
+        }
+        else
+        {
+            const Vector3 p = 0.5*(points[i - 1] + points[i]) + Vector3(0.0, 0.2, 0.0);
+            points.insert(points.begin() + i, p);
+            edited.InsertControlVertex(i, p);
+        }
+    }
+    CatmullSpline expected;
+    BuildFrom(expected, points, false);
+    ExpectSameSpline(expected, edited);
+    for (int i = 0; i < expected.GetNumberOfControlVertices(); i++)
+    {
+        ASSERT_NEAR(expected.GetSegmentStartT(i), edited.GetSegmentStartT(i), 1e-9);
+    }
+}
+
+TEST(CatmullRomEdit, ConstructResetsParameterRange)
+{
+    std::vector<Vector3> points = WavePoints(10);
+    CatmullSpline cspline;
+    BuildFrom(cspline, points, false);
+    const double max_t = cspline.GetMaxT();
+    for (int i = 0; i < 5; i++)
+    {
+        cspline.RemoveControlVertex(cspline.GetNumberOfControlVertices() - 1);
+    }
+    ASSERT_LT(cspline.GetMaxT(), max_t);
+    cspline.Construct();
+    ASSERT_DOUBLE_EQ(cspline.GetControlVertex(4)->T(), cspline.GetMaxT());
+    ASSERT_DOUBLE_EQ(0.0, cspline.GetMinT());
+}
+
+TEST(CatmullRomEdit, ChangeLog)
+{
+    std::vector<Vector3> points = WavePoints(20);
+    CatmullSpline cspline;
+    BuildFrom(cspline, points, false);
+    const std::uint64_t built = cspline.GetVersion();
+    std::vector<SplineChange> changes;
+    ASSERT_TRUE(cspline.GetChanges(built, changes));
+    ASSERT_TRUE(changes.empty());
+    cspline.MoveControlVertex(10, Vector3(5.0, 2.0, 0.0));
+    cspline.InsertControlVertex(15, Vector3(7.2, 1.0, 0.0));
+    ASSERT_TRUE(cspline.GetChanges(built, changes));
+    ASSERT_EQ(2u, changes.size());
+    ASSERT_EQ(8, changes[0].first);
+    ASSERT_EQ(4, changes[0].removed);
+    ASSERT_EQ(4, changes[0].added);
+    ASSERT_EQ(13, changes[1].first);
+    ASSERT_EQ(3, changes[1].removed);
+    ASSERT_EQ(4, changes[1].added);
+    ASSERT_NE(0.0, changes[1].knot_shift);
+    ASSERT_TRUE(cspline.GetChanges(cspline.GetVersion() - 1, changes));
+    ASSERT_EQ(1u, changes.size());
+    cspline.Construct();
+    ASSERT_FALSE(cspline.GetChanges(built, changes));
+}
+
+TEST(CatmullRomBatch, StridedEvaluateMatchesScalar)
+{
+    std::vector<Vector3> points = WavePoints(20);
+    CatmullSpline cspline;
+    BuildFrom(cspline, points, false);
+    // Evaluated with the knot shifts still pending
+    cspline.InsertControlVertex(10, Vector3(9.5, 1.0, 0.0));
+    ASSERT_NE(0.0, cspline.GetKnotOffset(15));
+    const int n = 64;
+    std::vector<double> t(n);
+    for (int i = 0; i < n; i++)
+    {
+        t[i] = cspline.GetMinT() + (cspline.GetMaxT() - cspline.GetMinT())*i/(n - 1);
+    }
+    std::vector<Vector3> r(n);
+    std::vector<Vector3> dr(n);
+    cspline.Evaluate(t.data(), n, r[0].coords, dr[0].coords);
+    // Column-major n x 3 positions
+    std::vector<double> columns(3*n);
+    cspline.Evaluate(t.data(), n, columns.data(), nullptr, nullptr, 1, n);
+    for (int i = 0; i < n; i++)
+    {
+        const Vector3 p = cspline.r(t[i]);
+        const Vector3 v = cspline.dr(t[i]);
+        for (int k = 0; k < 3; k++)
+        {
+            ASSERT_DOUBLE_EQ(p.coords[k], r[i].coords[k]);
+            ASSERT_DOUBLE_EQ(v.coords[k], dr[i].coords[k]);
+            ASSERT_DOUBLE_EQ(p.coords[k], columns[k*n + i]);
+        }
+    }
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,123 @@
+/*
+* Testing the control vertex decimation
+*/
+#include "../include/catmull_ros/decimation.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const double DECIMATION_TOLERANCE = 0.01;
+
+static double BruteForceDistance(CatmullSpline& spline, const Vector3& q)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < spline.GetNumberOfSegments(); i++)
+    {
+        std::shared_ptr<ControlVertex> cv = spline.GetControlVertex(i);
+        const double t = cv->ClosestParameter(q, spline.GetSegmentEndT(i));
+        best = std::min(best, Distance(cv->Hermite(t), q));
+    }
+    return best;
+}
+
+TEST(SplineDecimation, StraightLineKeepsEndPoints)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i < 100; i++)
+    {
+        cspline.AddControlVertex(Vector3(0.1*i, 0.05*i, 0.0));
+    }
+    cspline.Construct();
+    CatmullSpline decimated;
+    SplineDecimator decimator(cspline, DECIMATION_TOLERANCE);
+    DecimationResult result = decimator.Decimate(decimated);
+    ASSERT_EQ(100, result.original_vertices);
+    ASSERT_EQ(2, result.decimated_vertices);
+    ASSERT_DOUBLE_EQ(50.0, result.compression_ratio);
+    ASSERT_LE(result.max_error, DECIMATION_TOLERANCE);
+    ASSERT_DOUBLE_EQ(9.9, decimated.GetControlVertex(1)->P().X());
+}
+
+TEST(SplineDecimation, DenseTrackWithinTolerance)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i < 2000; i++)
+    {
+        const double x = 0.05*i;
+        cspline.AddControlVertex(Vector3(x, 3.0*sin(0.1*x), 0.0));
+    }
+    cspline.Construct();
+    CatmullSpline decimated;
+    SplineDecimator decimator(cspline, DECIMATION_TOLERANCE);
+    DecimationResult result = decimator.Decimate(decimated);
+    ASSERT_LT(result.decimated_vertices, 200);
+    ASSERT_GT(result.compression_ratio, 10.0);
+    ASSERT_LE(result.max_error, DECIMATION_TOLERANCE);
+    for (double t = cspline.GetMinT(); t < cspline.GetMaxT(); t += 0.37)
+    {
+        ASSERT_LE(BruteForceDistance(decimated, cspline.r(t)), result.max_error);
+    }
+}
+
+TEST(SplineDecimation, ErrorBoundsBothDirections)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i < 400; i++)
+    {
+        const double x = 0.1*i;
+        cspline.AddControlVertex(Vector3(x, 2.0*sin(0.3*x) + 0.5*sin(1.1*x), 0.0));
+    }
+    cspline.Construct();
+    CatmullSpline decimated;
+    SplineDecimator decimator(cspline, 0.05);
+    DecimationResult result = decimator.Decimate(decimated);
+    ASSERT_LT(result.decimated_vertices, 400);
+    ASSERT_LE(result.max_error, 0.05);
+    for (double t = cspline.GetMinT(); t < cspline.GetMaxT(); t += 0.01)
+    {
+        ASSERT_LE(BruteForceDistance(decimated, cspline.r(t)), result.max_error);
+    }
+    for (double t = decimated.GetMinT(); t < decimated.GetMaxT(); t += 0.01)
+    {
+        ASSERT_LE(BruteForceDistance(cspline, decimated.r(t)), result.max_error);
+    }
+}
+
+TEST(SplineDecimation, ClosedLoopWithinTolerance)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i < 500; i++)
+    {
+        const double phi = 2.0*M_PI*i/500.0;
+        cspline.AddControlVertex(Vector3(10.0*cos(phi), 10.0*sin(phi), 0.0));
+    }
+    cspline.ConstructLoop();
+    CatmullSpline decimated;
+    SplineDecimator decimator(cspline, DECIMATION_TOLERANCE);
+    DecimationResult result = decimator.Decimate(decimated);
+    ASSERT_TRUE(decimated.IsClosed());
+    ASSERT_LT(result.decimated_vertices, 100);
+    ASSERT_LE(result.max_error, DECIMATION_TOLERANCE);
+}
+
+TEST(SplineDecimation, TrivialSplineUnchanged)
+{
+    CatmullSpline cspline;
+    cspline.AddControlVertex(Vector3(0.0, 0.0, 0.0));
+    cspline.AddControlVertex(Vector3(1.0, 1.0, 0.0));
+    cspline.Construct();
+    CatmullSpline decimated;
+    SplineDecimator decimator(cspline, DECIMATION_TOLERANCE);
+    DecimationResult result = decimator.Decimate(decimated);
+    ASSERT_EQ(2, result.decimated_vertices);
+    ASSERT_DOUBLE_EQ(0.0, result.max_error);
+    ASSERT_DOUBLE_EQ(1.0, result.compression_ratio);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+/*
+* Testing the Eigen views and batch evaluation
+*/
+#include "../include/catmull_ros/eigen_interop.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+static void BuildCurve(CatmullSpline& cspline)
+{
+    for (int i = 0; i < 12; i++)
+    {
+        cspline.AddControlVertex(Vector3(i, sin(0.5*i), 0.1*i));
+    }
+    cspline.Construct();
+}
+
+static Eigen::VectorXd Parameters(CatmullSpline& cspline, int n)
+{
+    Eigen::VectorXd t(n);
+    for (int i = 0; i < n; i++)
+    {
+        t(i) = cspline.GetMinT() + (cspline.GetMaxT() - cspline.GetMinT())*i/(n - 1);
+    }
+    return t;
+}
+
+TEST(EigenInterop, ViewsShareMemory)
+{
+    Vector3 v(1.0, 2.0, 3.0);
+    Vector3Map view = AsEigen(v);
+    ASSERT_EQ(v.coords, view.data());
+    view *= 2.0;
+    ASSERT_DOUBLE_EQ(4.0, v.coords[1]);
+    std::vector<Vector3> samples;
+    samples.push_back(Vector3(1.0, 2.0, 3.0));
+    samples.push_back(Vector3(4.0, 5.0, 6.0));
+    SampleMap matrix = AsEigen(samples);
+    ASSERT_EQ(2, matrix.rows());
+    ASSERT_DOUBLE_EQ(6.0, matrix(1, 2));
+    matrix.col(0).setZero();
+    ASSERT_DOUBLE_EQ(0.0, samples[1].coords[0]);
+    const Eigen::Vector3d e(7.0, 8.0, 9.0);
+    ASSERT_DOUBLE_EQ(8.0, ToVector3(e).coords[1]);
+}
+
+TEST(EigenInterop, BatchEvaluationMatchesScalar)
+{
+    CatmullSpline cspline;
+    BuildCurve(cspline);
+    const Eigen::VectorXd t = Parameters(cspline, 101);
+    SampleMatrix r(t.size(), 3);
+    SampleMatrix dr(t.size(), 3);
+    SampleMatrix ddr(t.size(), 3);
+    Evaluate(cspline, t, r, dr, ddr);
+    // Column-major storage, written through the strides
+    Eigen::MatrixX3d r_col(t.size(), 3);
+    Evaluate(cspline, t, r_col);
+    for (int i = 0; i < t.size(); i++)
+    {
+        const Vector3 p = cspline.r(t(i));
+        const Vector3 v = cspline.dr(t(i));
+        const Vector3 a = cspline.ddr(t(i));
+        for (int k = 0; k < 3; k++)
+        {
+            ASSERT_DOUBLE_EQ(p.coords[k], r(i, k));
+            ASSERT_DOUBLE_EQ(p.coords[k], r_col(i, k));
+            ASSERT_DOUBLE_EQ(v.coords[k], dr(i, k));
+            ASSERT_DOUBLE_EQ(a.coords[k], ddr(i, k));
+        }
+    }
+    // Straight into a block of a larger matrix
+    Eigen::MatrixXd wide = Eigen::MatrixXd::Zero(t.size(), 5);
+    Evaluate(cspline, t, wide.middleCols(1, 3));
+    ASSERT_TRUE(wide.middleCols(1, 3).isApprox(r_col));
+    ASSERT_EQ(0.0, wide.col(0).norm());
+}
+
+TEST(EigenInterop, ControlVerticesAndCoefficients)
+{
+    Eigen::MatrixX3d points(12, 3);
+    for (int i = 0; i < 12; i++)
+    {
+        points.row(i) << i, sin(0.5*i), 0.1*i;
+    }
+    CatmullSpline from_eigen;
+    AddControlVertices(from_eigen, points);
+    from_eigen.Construct();
+    CatmullSpline reference;
+    BuildCurve(reference);
+    ASSERT_EQ(reference.GetNumberOfSegments(), from_eigen.GetNumberOfSegments());
+    CoefficientMatrix coefficients;
+    GetCoefficients(from_eigen, coefficients);
+    ASSERT_EQ(reference.GetNumberOfSegments(), coefficients.rows());
+    for (int i = 0; i < reference.GetNumberOfSegments(); i++)
+    {
+        std::shared_ptr<ControlVertex> cv = reference.GetControlVertex(i);
+        const Eigen::Vector3d a0 = coefficients.row(i).segment(0, 3).transpose();
+        const Eigen::Vector3d a3 = coefficients.row(i).segment(9, 3).transpose();
+        ASSERT_TRUE(a0.isApprox(AsEigen(cv->A0())));
+        ASSERT_TRUE(a3.isApprox(AsEigen(cv->A3())));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,160 @@
+/*
+* Testing the least-squares spline fitting
+*/
+#include "../include/catmull_ros/fitting.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const double FIT_NOISE = 0.05;
+const double FIT_SMOOTHNESS = 1.0;
+
+static double TrueCurve(double x)
+{
+    return 3.0*sin(0.2*x);
+}
+
+static std::vector<Vector3> NoisyPoints(int count)
+{
+    std::mt19937 generator(42);
+    std::normal_distribution<double> noise(0.0, FIT_NOISE);
+    std::vector<Vector3> points;
+    for (int i = 0; i < count; i++)
+    {
+        const double x = 0.02*i;
+        points.push_back(Vector3(x + noise(generator),
+            TrueCurve(x) + noise(generator), 0.0));
+    }
+    return points;
+}
+
+TEST(SplineFitting, BandedSolverMatchesDenseSolution)
+{
+    // Tridiagonal 2, -1 system with a known solution
+    BandedNormalEquations system;
+    system.Resize(5);
+    for (int i = 0; i < 5; i++)
+    {
+        system.Add(i, i, 2.0);
+        if (i > 0)
+        {
+            system.Add(i, i - 1, -1.0);
+        }
+    }
+    system.AddRhs(0, Vector3(1.0, 0.0, 0.0));
+    system.AddRhs(4, Vector3(1.0, 0.0, 0.0));
+    ASSERT_TRUE(system.Solve());
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_NEAR(1.0, system.X(i).coords[0], 1e-12);
+    }
+}
+
+TEST(SplineFitting, StraightLineIsReproduced)
+{
+    std::vector<Vector3> points;
+    for (int i = 0; i < 200; i++)
+    {
+        points.push_back(Vector3(0.1*i, 0.2*i, 0.0));
+    }
+    CatmullSpline cspline;
+    FitResult result = FitSpline(points, 10, FIT_SMOOTHNESS, cspline);
+    ASSERT_TRUE(result.success);
+    ASSERT_LT(result.max_residual, 1e-9);
+    ASSERT_EQ(10, cspline.GetNumberOfControlVertices());
+    for (int i = 0; i < 10; i++)
+    {
+        Vector3 p = cspline.GetControlVertex(i)->P();
+        ASSERT_NEAR(2.0*p.X(), p.Y(), 1e-9);
+    }
+}
+
+TEST(SplineFitting, NoisyPointsAreSmoothed)
+{
+    std::vector<Vector3> points = NoisyPoints(2000);
+    CatmullSpline cspline;
+    FitResult result = FitSpline(points, 40, FIT_SMOOTHNESS, cspline);
+    ASSERT_TRUE(result.success);
+    ASSERT_LT(result.rms_residual, 2.0*FIT_NOISE);
+    for (int i = 1; i < 39; i++)
+    {
+        Vector3 p = cspline.GetControlVertex(i)->P();
+        ASSERT_NEAR(TrueCurve(p.X()), p.Y(), FIT_NOISE);
+    }
+}
+
+TEST(SplineFitting, ResidualsAreMeasuredOnTheSpline)
+{
+    std::vector<Vector3> points = NoisyPoints(1000);
+    CatmullSpline cspline;
+    const int m = 12;
+    FitResult result = FitSpline(points, m, FIT_SMOOTHNESS, cspline);
+    ASSERT_TRUE(result.success);
+    std::vector<double> s(points.size(), 0.0);
+    for (std::size_t p = 1; p < points.size(); p++)
+    {
+        s[p] = s[p - 1] + Distance(points[p], points[p - 1]);
+    }
+    const double h = s.back() / (m - 1);
+    double sum = 0.0;
+    double max_d = 0.0;
+    for (std::size_t p = 0; p < points.size(); p++)
+    {
+        const int i = std::min(static_cast<int>(s[p] / h), m - 2);
+        const double t0 = cspline.GetSegmentStartT(i);
+        const double t = t0 + (s[p] / h - i)*(cspline.GetSegmentEndT(i) - t0);
+        const double d = Distance(cspline.r(t), points[p]);
+        sum += d*d;
+        max_d = std::max(max_d, d);
+        // No point of the spline is closer than the reported residual allows
+        double closest = Distance(cspline.r(0.0), points[p]);
+        const double end_t = cspline.GetSegmentEndT(m - 2);
+        for (int k = 1; k <= 2000; k++)
+        {
+            closest = std::min(closest, Distance(cspline.r(end_t*k/2000.0), points[p]));
+        }
+        ASSERT_LE(closest, result.max_residual + 1e-9);
+    }
+    ASSERT_NEAR(max_d, result.max_residual, 1e-9);
+    ASSERT_NEAR(sqrt(sum / points.size()), result.rms_residual, 1e-9);
+}
+
+TEST(SplineFitting, StreamingFollowsTheData)
+{
+    std::vector<Vector3> points = NoisyPoints(4000);
+    StreamingSplineFitter fitter(1.0, FIT_SMOOTHNESS, 16);
+    int retired = 0;
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        fitter.AddPoint(points[i]);
+        if (i % 10 == 9)
+        {
+            ASSERT_TRUE(fitter.Solve());
+        }
+        retired += fitter.TakeRetiredVertices().size();
+    }
+    ASSERT_TRUE(fitter.Solve());
+    ASSERT_GT(retired, 0);
+    ASSERT_EQ(retired, fitter.GetWindowOffset());
+    ASSERT_LE(fitter.GetNumberOfWindowVertices(), 16);
+    for (int i = 1; i < fitter.GetNumberOfWindowVertices() - 1; i++)
+    {
+        Vector3 p = fitter.GetWindowVertex(i);
+        ASSERT_NEAR(TrueCurve(p.X()), p.Y(), 2.0*FIT_NOISE);
+    }
+    CatmullSpline cspline;
+    FitResult result = fitter.BuildSpline(cspline);
+    ASSERT_TRUE(result.success);
+    ASSERT_LT(result.rms_residual, 2.0*FIT_NOISE);
+    ASSERT_EQ(fitter.GetNumberOfWindowVertices(), cspline.GetNumberOfControlVertices());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
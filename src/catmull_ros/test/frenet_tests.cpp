@@ -0,0 +1,161 @@
+/*
+* Testing the Cartesian-Frenet transformation
+*/
+#include "../include/catmull_ros/frenet.hpp"
+
+#include <cmath>
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const double FRENET_EPS = 1e-6;
+const std::size_t FRENET_CLOUD_SIZE = 100000;
+
+static void BuildRoad(CatmullSpline& cspline)
+{
+    for (int i = 0; i < 200; i++)
+    {
+        const double x = 2.0*i;
+        cspline.AddControlVertex(Vector3(x, 20.0*sin(0.02*x), 0.0));
+    }
+    cspline.Construct();
+}
+
+static std::vector<Vector3> Cloud(std::size_t n, double lateral)
+{
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> along(10.0, 388.0);
+    std::uniform_real_distribution<double> across(-lateral, lateral);
+    std::vector<Vector3> points(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const double x = along(generator);
+        points[i] = Vector3(x, 20.0*sin(0.02*x) + across(generator), 0.0);
+    }
+    return points;
+}
+
+static double BruteForceDistance(CatmullSpline& spline, const Vector3& q)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < spline.GetNumberOfSegments(); i++)
+    {
+        std::shared_ptr<ControlVertex> cv = spline.GetControlVertex(i);
+        const double t = cv->ClosestParameter(q, spline.GetSegmentEndT(i) - spline.GetKnotOffset(i));
+        best = std::min(best, Distance(cv->Hermite(t), q));
+    }
+    return best;
+}
+
+TEST(ArcLength, StraightLineLengthIsExact)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i < 5; i++)
+    {
+        cspline.AddControlVertex(Vector3(3.0*i, 4.0*i, 0.0));
+    }
+    cspline.Construct();
+    ArcLengthTable arc(cspline);
+    ASSERT_NEAR(20.0, arc.TotalLength(), 1e-9);
+    int segment;
+    double t;
+    arc.Invert(12.5, segment, t);
+    ASSERT_EQ(2, segment);
+    ASSERT_NEAR(12.5, arc.S(t), 1e-9);
+}
+
+TEST(ArcLength, UpdateAfterLocalEdits)
+{
+    CatmullSpline cspline;
+    BuildRoad(cspline);
+    ArcLengthTable arc(cspline);
+    SegmentBvh bvh(cspline);
+    cspline.MoveControlVertex(50, Vector3(100.0, 30.0, 0.0));
+    cspline.InsertControlVertex(120, Vector3(239.0, 0.0, 0.0));
+    cspline.RemoveControlVertex(3);
+    arc.Update(cspline);
+    ArcLengthTable rebuilt(cspline);
+    ASSERT_EQ(rebuilt.GetNumberOfSegments(), arc.GetNumberOfSegments());
+    for (int i = 0; i <= arc.GetNumberOfSegments(); i += 7)
+    {
+        const int k = std::min(i, arc.GetNumberOfSegments() - 1);
+        ASSERT_NEAR(rebuilt.SegmentStart(k), arc.SegmentStart(k), 1e-9);
+    }
+    ASSERT_NEAR(rebuilt.TotalLength(), arc.TotalLength(), 1e-9);
+    bvh.Update(cspline);
+    ASSERT_EQ(cspline.GetNumberOfSegments(), bvh.GetNumberOfSegments());
+    const Vector3 q(100.0, 29.0, 0.0);
+    double t;
+    double d2;
+    bvh.Closest(q, t, d2);
+    ASSERT_NEAR(BruteForceDistance(cspline, q), sqrt(d2), FRENET_EPS);
+    // The caches follow the knot shifts without applying them
+    ASSERT_NE(0.0, cspline.GetKnotOffset(cspline.GetNumberOfSegments() - 1));
+    ASSERT_NEAR(sqrt(d2), Distance(cspline.r(t), q), FRENET_EPS);
+    int segment;
+    double ts;
+    arc.Invert(arc.S(t), segment, ts);
+    ASSERT_NEAR(t, ts, 1e-6);
+    cspline.MoveControlVertex(150, Vector3(300.0, -40.0, 0.0));
+    bvh.Update(cspline);
+    const Vector3 far(300.0, -39.0, 0.0);
+    bvh.Closest(far, t, d2);
+    ASSERT_NEAR(BruteForceDistance(cspline, far), sqrt(d2), FRENET_EPS);
+}
+
+TEST(FrenetTransform, SinglePointOnStraightLine)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i < 5; i++)
+    {
+        cspline.AddControlVertex(Vector3(1.0*i, 0.0, 0.0));
+    }
+    cspline.Construct();
+    FrenetTransformer frenet(cspline);
+    FrenetPoint left = frenet.ToFrenet(Vector3(2.5, 1.5, 0.0));
+    ASSERT_NEAR(2.5, left.s, FRENET_EPS);
+    ASSERT_NEAR(1.5, left.d, FRENET_EPS);
+    FrenetPoint right = frenet.ToFrenet(Vector3(1.25, -0.5, 0.0));
+    ASSERT_NEAR(1.25, right.s, FRENET_EPS);
+    ASSERT_NEAR(-0.5, right.d, FRENET_EPS);
+    Vector3 back = frenet.ToCartesian(2.5, 1.5);
+    ASSERT_NEAR(2.5, back.X(), FRENET_EPS);
+    ASSERT_NEAR(1.5, back.Y(), FRENET_EPS);
+}
+
+TEST(FrenetTransform, BatchMatchesBruteForce)
+{
+    CatmullSpline cspline;
+    BuildRoad(cspline);
+    FrenetTransformer frenet(cspline);
+    std::vector<Vector3> points = Cloud(5000, 30.0);
+    std::vector<FrenetPoint> result(points.size());
+    frenet.ToFrenet(points.data(), points.size(), result.data());
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        ASSERT_NEAR(BruteForceDistance(cspline, points[i]), fabs(result[i].d), FRENET_EPS);
+    }
+}
+
+TEST(FrenetTransform, RoundTripNearThePath)
+{
+    CatmullSpline cspline;
+    BuildRoad(cspline);
+    FrenetTransformer frenet(cspline);
+    std::vector<Vector3> points = Cloud(FRENET_CLOUD_SIZE, 5.0);
+    std::vector<FrenetPoint> result(points.size());
+    frenet.ToFrenet(points.data(), points.size(), result.data());
+    std::vector<Vector3> back(points.size());
+    frenet.ToCartesian(result.data(), result.size(), back.data());
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        ASSERT_LT((back[i] - points[i]).GetNorm(), 1e-5) << i;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
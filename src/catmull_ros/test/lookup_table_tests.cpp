@@ -0,0 +1,77 @@
+/*
+* Testing the lookup table evaluation
+*/
+#include "../include/catmull_ros/lookup_table.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+static void BuildPath(CatmullSpline& cspline, int vertices)
+{
+    for (int i = 0; i < vertices; i++)
+    {
+        cspline.AddControlVertex(Vector3(3.0*i, 8.0*sin(0.2*i), 0.5*cos(0.1*i)));
+    }
+    cspline.Construct();
+}
+
+/*
+Largest position and velocity deviation from the exact evaluation
+*/
+static void MeasureError(CatmullSpline& cspline, const SplineLookupTable& table,
+    double& e_position, double& e_velocity)
+{
+    e_position = 0.0;
+    e_velocity = 0.0;
+    const int n = 200000;
+    for (int i = 0; i < n; i++)
+    {
+        const double t = table.GetMinT() + (table.GetMaxT() - table.GetMinT())*i/(n - 1.0);
+        const int segment = std::min(cspline.GetNumberOfSegments() - 1, std::max(0, cspline.FindSegment(t)));
+        std::shared_ptr<ControlVertex> cv = cspline.GetControlVertex(segment);
+        e_position = std::max(e_position, Distance(cv->Hermite(t), table.r(t)));
+        e_velocity = std::max(e_velocity, Distance(cv->dhermite(t), table.dr(t)));
+    }
+}
+
+TEST(LookupTable, LinearWithinErrorBound)
+{
+    CatmullSpline cspline;
+    BuildPath(cspline, 200);
+    SplineLookupTable table(cspline, 0.01);
+    ASSERT_LE(table.GetErrorBound(), 0.01);
+    double e_position, e_velocity;
+    MeasureError(cspline, table, e_position, e_velocity);
+    ASSERT_LE(e_position, table.GetErrorBound() + 1e-12);
+    ASSERT_LE(e_velocity, table.GetVelocityErrorBound() + 1e-12);
+    // The bound is not wildly pessimistic
+    ASSERT_GT(e_position, 0.1*table.GetErrorBound());
+    SplineLookupTable fine(cspline, 0.0001);
+    ASSERT_LE(fine.GetErrorBound(), 0.0001);
+    ASSERT_GT(fine.GetNumberOfIntervals(), table.GetNumberOfIntervals());
+}
+
+TEST(LookupTable, QuadraticWithinErrorBound)
+{
+    CatmullSpline cspline;
+    BuildPath(cspline, 200);
+    SplineLookupTable table(cspline, 0.001, LOOKUP_QUADRATIC);
+    SplineLookupTable linear(cspline, 0.001, LOOKUP_LINEAR);
+    ASSERT_LE(table.GetErrorBound(), 0.001);
+    double e_position, e_velocity;
+    MeasureError(cspline, table, e_position, e_velocity);
+    ASSERT_LE(e_position, table.GetErrorBound() + 1e-12);
+    ASSERT_LE(e_velocity, table.GetVelocityErrorBound() + 1e-12);
+    ASSERT_LT(table.GetNumberOfNodes(), linear.GetNumberOfNodes());
+    // Queries outside of the range are clamped to the ends
+    ASSERT_NEAR(0.0, Distance(table.r(table.GetMaxT() + 1.0), cspline.r(cspline.GetMaxT())), 1e-9);
+    ASSERT_NEAR(0.0, Distance(table.r(table.GetMinT() - 1.0), cspline.r(cspline.GetMinT())), 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,161 @@
+/*
+* Testing the offset curve generation
+*/
+#include "../include/catmull_ros/offset_curve.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const double OFFSET_EPS = 1e-6;
+
+static void BuildArc(CatmullSpline& cspline, double radius)
+{
+    // Half circle turning left around the origin
+    for (int i = 0; i <= 36; i++)
+    {
+        const double phi = -M_PI_2 + M_PI*i/36.0;
+        cspline.AddControlVertex(Vector3(radius*cos(phi), radius*sin(phi), 0.0));
+    }
+    cspline.Construct();
+}
+
+static bool SelfIntersects(const std::vector<Vector3>& polyline)
+{
+    for (std::size_t i = 0; i + 1 < polyline.size(); i++)
+    {
+        for (std::size_t j = i + 2; j + 1 < polyline.size(); j++)
+        {
+            Vector3 x;
+            if (IntersectSegments2D(polyline[i], polyline[i + 1],
+                polyline[j], polyline[j + 1], x))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+TEST(OffsetCurve, StraightLineOffsets)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i < 5; i++)
+    {
+        cspline.AddControlVertex(Vector3(2.0*i, 0.0, 0.0));
+    }
+    cspline.Construct();
+    OffsetCurveGenerator generator(cspline, 0.5);
+    ASSERT_EQ(17, generator.GetNumberOfSamples());
+    std::vector<double> distances;
+    distances.push_back(-1.5);
+    distances.push_back(0.0);
+    distances.push_back(2.0);
+    std::vector<std::vector<Vector3> > polylines;
+    generator.Offset(distances, polylines);
+    ASSERT_EQ(3u, polylines.size());
+    for (std::size_t k = 0; k < distances.size(); k++)
+    {
+        ASSERT_EQ(17u, polylines[k].size());
+        for (std::size_t i = 0; i < polylines[k].size(); i++)
+        {
+            ASSERT_NEAR(0.5*i, polylines[k][i].coords[0], OFFSET_EPS);
+            ASSERT_NEAR(distances[k], polylines[k][i].coords[1], OFFSET_EPS);
+        }
+    }
+}
+
+TEST(OffsetCurve, ConvexSideKeepsDistance)
+{
+    CatmullSpline cspline;
+    BuildArc(cspline, 10.0);
+    OffsetCurveGenerator generator(cspline, 0.25);
+    // The end segments of an open spline deviate from the circle
+    for (int i = 20; i < generator.GetNumberOfSamples() - 20; i++)
+    {
+        ASSERT_NEAR(0.1, generator.GetCurvature(i), 1e-3);
+    }
+    std::vector<double> distances(1, -4.0);
+    std::vector<std::vector<Vector3> > polylines;
+    generator.Offset(distances, polylines);
+    ASSERT_EQ(generator.GetNumberOfSamples(), static_cast<int>(polylines[0].size()));
+    for (std::size_t i = 0; i < polylines[0].size(); i++)
+    {
+        ASSERT_NEAR(14.0, polylines[0][i].GetNorm(), 1e-2);
+    }
+}
+
+TEST(OffsetCurve, SwallowtailIsTrimmed)
+{
+    // Straight approach, a left turn of radius 2 and a straight exit: the
+    // offset of 3 to the left folds over inside the turn
+    CatmullSpline cspline;
+    for (int i = 0; i < 10; i++)
+    {
+        cspline.AddControlVertex(Vector3(i - 10.0, -2.0, 0.0));
+    }
+    for (int i = 0; i <= 6; i++)
+    {
+        const double phi = -M_PI_2 + M_PI_2*i/6.0;
+        cspline.AddControlVertex(Vector3(2.0*cos(phi), 2.0*sin(phi), 0.0));
+    }
+    for (int i = 1; i <= 10; i++)
+    {
+        cspline.AddControlVertex(Vector3(2.0, 1.0*i, 0.0));
+    }
+    cspline.Construct();
+    OffsetCurveGenerator generator(cspline, 0.1);
+    std::vector<double> distances;
+    distances.push_back(1.0);
+    distances.push_back(3.0);
+    std::vector<std::vector<Vector3> > polylines;
+    generator.Offset(distances, polylines);
+    const int n = generator.GetNumberOfSamples();
+    std::vector<Vector3> raw(2*n);
+    generator.OffsetRaw(distances.data(), distances.size(), raw.data());
+    std::vector<Vector3> raw_narrow(raw.begin(), raw.begin() + n);
+    std::vector<Vector3> raw_wide(raw.begin() + n, raw.end());
+    ASSERT_FALSE(SelfIntersects(raw_narrow));
+    ASSERT_EQ(n, static_cast<int>(polylines[0].size()));
+    ASSERT_TRUE(SelfIntersects(raw_wide));
+    ASSERT_FALSE(SelfIntersects(polylines[1]));
+    ASSERT_LT(polylines[1].size(), raw_wide.size());
+    // The loop is cut at the corner of the two offset lines
+    bool corner = false;
+    for (std::size_t i = 0; i < polylines[1].size(); i++)
+    {
+        if (Distance(polylines[1][i], Vector3(-1.0, 1.0, 0.0)) < 1e-2)
+        {
+            corner = true;
+        }
+    }
+    ASSERT_TRUE(corner);
+    ASSERT_NEAR(-10.0, polylines[1].front().coords[0], OFFSET_EPS);
+    ASSERT_NEAR(1.0, polylines[1].front().coords[1], OFFSET_EPS);
+    ASSERT_NEAR(-1.0, polylines[1].back().coords[0], OFFSET_EPS);
+    ASSERT_NEAR(10.0, polylines[1].back().coords[1], OFFSET_EPS);
+}
+
+TEST(OffsetCurve, RefittedSplineWithinTolerance)
+{
+    CatmullSpline cspline;
+    BuildArc(cspline, 10.0);
+    OffsetCurveGenerator generator(cspline, 0.25);
+    CatmullSpline offset;
+    DecimationResult result = generator.OffsetSpline(-2.0, 0.01, offset);
+    ASSERT_LE(result.max_error, 0.01);
+    ASSERT_LT(result.decimated_vertices, result.original_vertices);
+    for (int i = 0; i < offset.GetNumberOfSegments(); i++)
+    {
+        std::shared_ptr<ControlVertex> cv = offset.GetControlVertex(i);
+        const double t = 0.5*(cv->T() + offset.GetSegmentEndT(i));
+        ASSERT_NEAR(12.0, cv->Hermite(t).GetNorm(), 0.05);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
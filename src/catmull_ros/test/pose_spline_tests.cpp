@@ -0,0 +1,136 @@
+/*
+* Testing the orientation-aware pose spline
+*/
+#include "../include/catmull_ros/pose_spline.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const double POSE_EPS = 1e-6;
+
+static Vector3 RotationBetween(const Quaternion& q0, const Quaternion& q1)
+{
+    return (q0.Conjugate() * q1).Log();
+}
+
+static void BuildHelix(CatmullSpline& cspline, PoseSpline& pspline)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        const double phi = 0.6*i;
+        cspline.AddControlVertex(Vector3(3.0*cos(phi), 3.0*sin(phi), 0.5*i));
+        pspline.AddOrientation(
+            Quaternion::Exp(Vector3(0.1*i, -0.2*sin(phi), 0.7*i)));
+    }
+    cspline.Construct();
+}
+
+TEST(QuaternionBasic, ExpLogRoundTrip)
+{
+    Vector3 phi(0.3, -0.4, 1.2);
+    Vector3 res = Quaternion::Exp(phi).Log();
+    ASSERT_NEAR(0.3, res.X(), 1e-12);
+    ASSERT_NEAR(-0.4, res.Y(), 1e-12);
+    ASSERT_NEAR(1.2, res.Z(), 1e-12);
+    Vector3 r = Quaternion::Exp(Vector3(0.0, 0.0, M_PI/2)).Rotate(Vector3(1.0, 0.0, 0.0));
+    ASSERT_NEAR(0.0, r.X(), 1e-12);
+    ASSERT_NEAR(1.0, r.Y(), 1e-12);
+}
+
+TEST(PoseSplineBasic, InterpolatesOrientationsAtKnots)
+{
+    CatmullSpline cspline;
+    PoseSpline pspline(cspline);
+    BuildHelix(cspline, pspline);
+    ASSERT_TRUE(pspline.Construct());
+    for (int i = 0; i < 7; i++)
+    {
+        const double t = cspline.GetControlVertex(i)->T();
+        Quaternion expected = Quaternion::Exp(
+            Vector3(0.1*i, -0.2*sin(0.6*i), 0.7*i));
+        ASSERT_LT(RotationBetween(expected, pspline.q(t)).GetNorm(), 1e-9);
+    }
+}
+
+TEST(PoseSplineBasic, AngularRatesMatchFiniteDifferences)
+{
+    CatmullSpline cspline;
+    PoseSpline pspline(cspline);
+    BuildHelix(cspline, pspline);
+    ASSERT_TRUE(pspline.Construct());
+    const double h = 1e-5;
+    for (double t = 0.1; t < cspline.GetMaxT() - 0.1; t += 0.37)
+    {
+        Vector3 omega = pspline.omega(t);
+        Vector3 fd = RotationBetween(pspline.q(t - h), pspline.q(t + h)) / (2.0*h);
+        ASSERT_NEAR(omega.X(), fd.X(), POSE_EPS);
+        ASSERT_NEAR(omega.Y(), fd.Y(), POSE_EPS);
+        ASSERT_NEAR(omega.Z(), fd.Z(), POSE_EPS);
+        Vector3 alpha = pspline.alpha(t);
+        Vector3 fda = (pspline.omega(t + h) - pspline.omega(t - h)) / (2.0*h);
+        ASSERT_NEAR(alpha.X(), fda.X(), 1e-4);
+        ASSERT_NEAR(alpha.Y(), fda.Y(), 1e-4);
+        ASSERT_NEAR(alpha.Z(), fda.Z(), 1e-4);
+    }
+}
+
+TEST(PoseSplineBasic, AngularVelocityContinuousAtKnots)
+{
+    CatmullSpline cspline;
+    PoseSpline pspline(cspline);
+    BuildHelix(cspline, pspline);
+    ASSERT_TRUE(pspline.Construct());
+    for (int i = 1; i < 7; i++)
+    {
+        const double t = cspline.GetControlVertex(i)->T();
+        PoseSample before, after;
+        pspline.Evaluate(t - 1e-9, before);
+        pspline.Evaluate(t, after);
+        Vector3 omega_before = before.orientation.Rotate(before.angular_velocity);
+        Vector3 omega_after = after.orientation.Rotate(after.angular_velocity);
+        ASSERT_LT((omega_before - omega_after).GetNorm(), POSE_EPS);
+    }
+}
+
+TEST(PoseSplineBasic, BatchedMatchesSingleEvaluation)
+{
+    CatmullSpline cspline;
+    PoseSpline pspline(cspline);
+    BuildHelix(cspline, pspline);
+    ASSERT_TRUE(pspline.Construct());
+    std::vector<double> t(1000);
+    for (std::size_t i = 0; i < t.size(); i++)
+    {
+        t[i] = cspline.GetMaxT() * i / t.size();
+    }
+    std::vector<PoseSample> samples(t.size());
+    pspline.Evaluate(t.data(), t.size(), samples.data());
+    for (std::size_t i = 0; i < t.size(); i++)
+    {
+        PoseSample single;
+        pspline.Evaluate(t[i], single);
+        ASSERT_DOUBLE_EQ(single.position.X(), samples[i].position.X());
+        ASSERT_DOUBLE_EQ(single.orientation.w, samples[i].orientation.w);
+        ASSERT_DOUBLE_EQ(single.angular_velocity.Z(), samples[i].angular_velocity.Z());
+        ASSERT_LT((cspline.r(t[i]) - samples[i].position).GetNorm(), 1e-12);
+    }
+}
+
+TEST(PoseSplineBasic, MismatchedOrientationsRejected)
+{
+    CatmullSpline cspline;
+    PoseSpline pspline(cspline);
+    cspline.AddControlVertex(Vector3(0.0, 0.0, 0.0));
+    cspline.AddControlVertex(Vector3(1.0, 0.0, 0.0));
+    cspline.Construct();
+    pspline.AddOrientation(Quaternion());
+    ASSERT_FALSE(pspline.Construct());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,135 @@
+/*
+* Testing the lazy sampling pipelines
+*/
+#include "../include/catmull_ros/sampling_pipeline.hpp"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const double PIPELINE_EPS = 1e-9;
+
+static void BuildWave(CatmullSpline& cspline, int vertices)
+{
+    for (int i = 0; i < vertices; i++)
+    {
+        cspline.AddControlVertex(Vector3(i, 2.0*sin(0.4*i), 0.0));
+    }
+    cspline.Construct();
+}
+
+TEST(SamplingPipeline, UniformTMatchesSplineEvaluation)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline, 30);
+    UniformTSampler sampler(cspline, 101);
+    std::vector<PathSample> samples;
+    sampler.Collect(samples);
+    ASSERT_EQ(101u, samples.size());
+    for (std::size_t i = 0; i < samples.size(); i++)
+    {
+        const double t = cspline.GetMinT() + (cspline.GetMaxT() - cspline.GetMinT())*i/100.0;
+        ASSERT_NEAR(t, samples[i].t, PIPELINE_EPS);
+        const Vector3 p = cspline.r(t);
+        ASSERT_NEAR(0.0, Distance(p, samples[i].p), PIPELINE_EPS);
+    }
+}
+
+TEST(SamplingPipeline, UniformSAndAdaptive)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline, 30);
+    UniformSSampler uniform(cspline, 0.5);
+    std::vector<PathSample> samples;
+    uniform.Collect(samples);
+    ASSERT_EQ(uniform.Size(), samples.size());
+    for (std::size_t i = 1; i + 1 < samples.size(); i++)
+    {
+        // Chords are slightly shorter than the arcs
+        const double chord = Distance(samples[i].p, samples[i - 1].p);
+        ASSERT_LE(chord, 0.5 + 1e-6);
+        ASSERT_GT(chord, 0.49);
+    }
+    std::vector<PathSample> coarse;
+    std::vector<PathSample> fine;
+    AdaptiveSampler(cspline, 0.05).Collect(coarse);
+    AdaptiveSampler(cspline, 0.001).Collect(fine);
+    ASSERT_GT(fine.size(), coarse.size());
+    ASSERT_NEAR(0.0, Distance(fine.front().p, cspline.r(cspline.GetMinT())), PIPELINE_EPS);
+    ASSERT_NEAR(0.0, Distance(fine.back().p, cspline.r(cspline.GetMaxT())), PIPELINE_EPS);
+    for (std::size_t i = 1; i < fine.size(); i++)
+    {
+        ASSERT_LT(fine[i - 1].t, fine[i].t);
+    }
+}
+
+TEST(SamplingPipeline, MapFilterChunkInOnePass)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline, 30);
+    UniformSSampler sampler(cspline, 0.25);
+    // Shift into another frame and keep the upper half plane
+    auto pipeline = sampler
+        .Map([](const PathSample& s) { return Vector3(s.p.coords[0] - 5.0, s.p.coords[1], 1.0); })
+        .Filter([](const Vector3& p) { return p.coords[1] > 0.0; });
+    std::vector<PathSample> all;
+    sampler.Collect(all);
+    std::vector<Vector3> expected;
+    for (std::size_t i = 0; i < all.size(); i++)
+    {
+        if (all[i].p.coords[1] > 0.0)
+        {
+            expected.push_back(Vector3(all[i].p.coords[0] - 5.0, all[i].p.coords[1], 1.0));
+        }
+    }
+    std::vector<Vector3> streamed;
+    std::size_t largest = 0;
+    pipeline.ForEachChunk(7, [&](const Vector3* data, std::size_t count)
+        {
+            largest = std::max(largest, count);
+            streamed.insert(streamed.end(), data, data + count);
+        });
+    ASSERT_EQ(7u, largest);
+    ASSERT_EQ(expected.size(), streamed.size());
+    for (std::size_t i = 0; i < expected.size(); i++)
+    {
+        ASSERT_NEAR(0.0, Distance(expected[i], streamed[i]), PIPELINE_EPS);
+    }
+}
+
+TEST(SamplingPipeline, ParallelPartsMatchSequential)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline, 200);
+    auto pipeline = AdaptiveSampler(cspline, 0.001)
+        .Filter([](const PathSample& s) { return s.p.coords[0] < 150.0; })
+        .Map([](const PathSample& s) { return s.t; });
+    std::vector<double> sequential;
+    pipeline.Collect(sequential);
+    std::mutex mutex;
+    std::map<std::size_t, std::vector<double> > parts;
+    pipeline.ParallelForEachChunk(16, 10, [&](std::size_t part, const double* data, std::size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            parts[part].insert(parts[part].end(), data, data + count);
+        });
+    std::vector<double> parallel;
+    for (std::map<std::size_t, std::vector<double> >::iterator it = parts.begin(); it != parts.end(); ++it)
+    {
+        parallel.insert(parallel.end(), it->second.begin(), it->second.end());
+    }
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (std::size_t i = 0; i < sequential.size(); i++)
+    {
+        ASSERT_EQ(sequential[i], parallel[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
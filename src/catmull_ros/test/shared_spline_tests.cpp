@@ -0,0 +1,224 @@
+/*
+* Testing the shared memory spline publication
+*/
+#include "../include/catmull_ros/shared_spline.hpp"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <gtest/gtest.h>
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+using namespace catmull_ros;
+
+const int SHARED_SPLINE_UPDATES = 500;
+
+/*
+Region name unique to the test, removed at the end of the test
+*/
+struct SharedName
+{
+    std::string name;
+
+    SharedName()
+    {
+        static int counter = 0;
+        name = "/catmull_ros_shared_spline_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+    }
+
+    ~SharedName()
+    {
+        SharedSplinePublisher::Remove(name);
+    }
+};
+
+static void BuildPath(CatmullSpline& cspline, double offset)
+{
+    for (int i = 0; i < 50; i++)
+    {
+        cspline.AddControlVertex(Vector3(1.0*i, offset + sin(0.2*i), 0.0));
+    }
+    cspline.Construct();
+}
+
+TEST(SharedSpline, ViewMatchesSpline)
+{
+    const SharedName shm;
+    CatmullSpline cspline;
+    BuildPath(cspline, 0.0);
+    SharedSplinePublisher publisher(shm.name, 64);
+    ASSERT_TRUE(publisher.IsOpen());
+    ASSERT_TRUE(publisher.Publish(cspline));
+    SharedSplineView view(shm.name);
+    ASSERT_TRUE(view.IsOpen());
+    ASSERT_EQ(1u, view.GetVersion());
+    for (double t = 0.0; t < cspline.GetMaxT(); t += 0.37)
+    {
+        const Vector3 r = cspline.r(t);
+        const Vector3 dr = cspline.dr(t);
+        const Vector3 ddr = cspline.ddr(t);
+        const Vector3 sr = view.r(t);
+        const Vector3 sdr = view.dr(t);
+        const Vector3 sddr = view.ddr(t);
+        for (int k = 0; k < 3; k++)
+        {
+            ASSERT_EQ(r.coords[k], sr.coords[k]);
+            ASSERT_EQ(dr.coords[k], sdr.coords[k]);
+            ASSERT_EQ(ddr.coords[k], sddr.coords[k]);
+        }
+    }
+    Vector3 r, dr, ddr;
+    ASSERT_FALSE(view.Evaluate(cspline.GetMaxT() + 1.0, r, dr, ddr));
+}
+
+TEST(SharedSpline, RejectsTooManySegments)
+{
+    const SharedName shm;
+    CatmullSpline cspline;
+    BuildPath(cspline, 0.0);
+    SharedSplinePublisher publisher(shm.name, 16);
+    ASSERT_TRUE(publisher.IsOpen());
+    ASSERT_FALSE(publisher.Publish(cspline));
+    const SharedName unused;
+    SharedSplineView missing(unused.name);
+    ASSERT_FALSE(missing.IsOpen());
+    ASSERT_EQ(0u, missing.GetVersion());
+    Vector3 r, dr, ddr;
+    ASSERT_FALSE(missing.Evaluate(1.0, r, dr, ddr));
+    ASSERT_EQ(0.0, missing.r(1.0).GetSquaredNorm());
+}
+
+TEST(SharedSpline, RestartedPublisherKeepsRegion)
+{
+    const SharedName shm;
+    CatmullSpline cspline;
+    BuildPath(cspline, 0.0);
+    std::unique_ptr<SharedSplinePublisher> publisher(new SharedSplinePublisher(shm.name, 64));
+    ASSERT_TRUE(publisher->Publish(cspline));
+    SharedSplineView view(shm.name);
+    ASSERT_EQ(1u, view.GetVersion());
+    // The region outlives its publisher, a restart keeps the data and
+    // advances the version
+    publisher.reset();
+    ASSERT_EQ(cspline.r(5.0).coords[1], view.r(5.0).coords[1]);
+    publisher.reset(new SharedSplinePublisher(shm.name, 64));
+    ASSERT_TRUE(publisher->IsOpen());
+    ASSERT_EQ(2u, view.GetVersion());
+    ASSERT_EQ(cspline.r(5.0).coords[1], view.r(5.0).coords[1]);
+    CatmullSpline shifted;
+    BuildPath(shifted, 1.0);
+    ASSERT_TRUE(publisher->Publish(shifted));
+    ASSERT_EQ(3u, view.GetVersion());
+    ASSERT_EQ(shifted.r(5.0).coords[1], view.r(5.0).coords[1]);
+    // Another capacity is refused instead of resizing the mapped region
+    publisher.reset();
+    publisher.reset(new SharedSplinePublisher(shm.name, 128));
+    ASSERT_FALSE(publisher->IsOpen());
+    ASSERT_EQ(shifted.r(5.0).coords[1], view.r(5.0).coords[1]);
+    ASSERT_TRUE(SharedSplinePublisher::Remove(shm.name));
+    publisher.reset(new SharedSplinePublisher(shm.name, 128));
+    ASSERT_TRUE(publisher->IsOpen());
+    ASSERT_EQ(0u, SharedSplineView(shm.name).GetVersion());
+    // The old view keeps its orphaned region
+    ASSERT_EQ(3u, view.GetVersion());
+}
+
+TEST(SharedSpline, UnfinishedPublicationIsStale)
+{
+    const SharedName shm;
+    CatmullSpline cspline;
+    BuildPath(cspline, 0.0);
+    SharedSplinePublisher publisher(shm.name, 64);
+    ASSERT_TRUE(publisher.Publish(cspline));
+    SharedSplineView view(shm.name);
+    // Leave the sequence odd, as a publisher dying while writing does
+    const int fd = shm_open(shm.name.c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    void* memory = mmap(nullptr, sizeof(SharedSplineHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, memory);
+    SharedSplineHeader* header = static_cast<SharedSplineHeader*>(memory);
+    header->sequence.fetch_add(1);
+    Vector3 r, dr, ddr;
+    ASSERT_FALSE(view.Evaluate(5.0, r, dr, ddr));
+    ASSERT_EQ(0.0, r.GetSquaredNorm());
+    header->sequence.fetch_add(1);
+    ASSERT_TRUE(view.Evaluate(5.0, r, dr, ddr));
+    ASSERT_EQ(cspline.r(5.0).coords[1], r.coords[1]);
+    munmap(memory, sizeof(SharedSplineHeader));
+}
+
+TEST(SharedSpline, TwoProcessUpdatesInOrder)
+{
+    const SharedName shm;
+    SharedSplinePublisher publisher(shm.name, 64);
+    ASSERT_TRUE(publisher.IsOpen());
+    int pipes[2];
+    ASSERT_EQ(0, pipe(pipes));
+    const pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        // Controller: wait for every update and report whether it matches
+        close(pipes[0]);
+        SharedSplineView view(shm.name);
+        std::uint32_t last = 0;
+        for (int k = 1; k <= SHARED_SPLINE_UPDATES; k++)
+        {
+            Vector3 r, dr, ddr;
+            std::uint32_t version = last;
+            while (version == last)
+            {
+                if (!view.IsOpen() || view.GetVersion() == last)
+                {
+                    sched_yield();
+                    continue;
+                }
+                view.Evaluate(10.0, r, dr, ddr, &version);
+            }
+            std::int32_t matches = 1;
+            // The path of update k is shifted by k
+            CatmullSpline reference;
+            BuildPath(reference, k);
+            if (fabs(r.coords[1] - reference.r(10.0).coords[1]) > 1e-9
+                || version != static_cast<std::uint32_t>(k))
+            {
+                matches = 0;
+            }
+            last = version;
+            if (write(pipes[1], &matches, sizeof(matches)) != sizeof(matches))
+            {
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+    close(pipes[1]);
+    for (int k = 1; k <= SHARED_SPLINE_UPDATES; k++)
+    {
+        CatmullSpline cspline;
+        BuildPath(cspline, k);
+        publisher.Publish(cspline);
+        std::int32_t matches = 0;
+        if (read(pipes[0], &matches, sizeof(matches)) != sizeof(matches) || matches == 0)
+        {
+            ADD_FAILURE() << "update " << k << " was not received";
+            kill(child, SIGKILL);
+            break;
+        }
+    }
+    int status;
+    waitpid(child, &status, 0);
+    close(pipes[0]);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,147 @@
+/*
+* Testing the Hausdorff and Frechet distance queries
+*/
+#include "../include/catmull_ros/spline_distance.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+static void BuildRoad(CatmullSpline& cspline, int vertices, double offset, double bump)
+{
+    // Gently winding road sampled every 2 meters, with an optional lateral
+    // bump in the middle
+    for (int i = 0; i < vertices; i++)
+    {
+        const double x = 2.0*i;
+        double y = 5.0*sin(0.01*x) + offset;
+        if (i == vertices/2)
+        {
+            y += bump;
+        }
+        cspline.AddControlVertex(Vector3(x, y, 0.0));
+    }
+    cspline.Construct();
+}
+
+/*
+Dense brute force distance from the point to the samples of the spline
+*/
+static double BruteForceDistance(const Vector3& q, const std::vector<Vector3>& samples)
+{
+    double best = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < samples.size(); i++)
+    {
+        best = std::min(best, Distance(q, samples[i]));
+    }
+    return best;
+}
+
+static std::vector<Vector3> DenseSamples(CatmullSpline& cspline, int per_segment)
+{
+    std::vector<Vector3> samples;
+    for (int i = 0; i < cspline.GetNumberOfSegments(); i++)
+    {
+        std::shared_ptr<ControlVertex> cv = cspline.GetControlVertex(i);
+        const double t0 = cv->T();
+        const double t1 = cspline.GetSegmentEndT(i);
+        for (int k = 0; k <= per_segment; k++)
+        {
+            samples.push_back(cv->Hermite(t0 + (t1 - t0)*k/per_segment));
+        }
+    }
+    return samples;
+}
+
+TEST(SplineDistance, HausdorffMatchesBruteForce)
+{
+    CatmullSpline reference;
+    CatmullSpline trajectory;
+    BuildRoad(reference, 60, 0.0, 0.0);
+    BuildRoad(trajectory, 60, 0.3, 1.5);
+    SplineDistance distance(trajectory, reference, 0.5);
+    const DistanceBound bound = distance.DirectedHausdorffAB(1e-4);
+    ASSERT_LE(bound.lower, bound.upper);
+    ASSERT_LE(bound.upper - bound.lower, 1e-4 + 1e-12);
+    std::vector<Vector3> dense_trajectory = DenseSamples(trajectory, 200);
+    std::vector<Vector3> dense_reference = DenseSamples(reference, 200);
+    double expected = 0.0;
+    for (std::size_t i = 0; i < dense_trajectory.size(); i++)
+    {
+        expected = std::max(expected, BruteForceDistance(dense_trajectory[i], dense_reference));
+    }
+    // The brute force reference is itself sampled
+    ASSERT_NEAR(expected, bound.lower, 2e-3);
+    ASSERT_GT(bound.lower, 1.5);
+    const DistanceBound symmetric = distance.Hausdorff(1e-4);
+    ASSERT_GE(symmetric.lower, bound.lower - 1e-12);
+}
+
+TEST(SplineDistance, ThresholdQueries)
+{
+    CatmullSpline reference;
+    CatmullSpline trajectory;
+    BuildRoad(reference, 500, 0.0, 0.0);
+    BuildRoad(trajectory, 500, 0.2, 1.0);
+    SplineDistance distance(trajectory, reference, 1.0);
+    const DistanceBound bound = distance.Hausdorff(1e-4);
+    ASSERT_TRUE(distance.HausdorffWithin(bound.upper + 1e-3));
+    ASSERT_FALSE(distance.HausdorffWithin(bound.lower - 1e-3));
+    // The lateral offset alone is within 0.25, the bump is not
+    ASSERT_FALSE(distance.DirectedHausdorffWithin(0.25));
+    CatmullSpline shifted;
+    BuildRoad(shifted, 500, 0.2, 0.0);
+    SplineDistance shifted_distance(shifted, reference, 1.0);
+    ASSERT_TRUE(shifted_distance.HausdorffWithin(0.25));
+    ASSERT_FALSE(shifted_distance.HausdorffWithin(0.15));
+}
+
+TEST(SplineDistance, FrechetSeesTheDirection)
+{
+    CatmullSpline forward;
+    CatmullSpline backward;
+    for (int i = 0; i <= 20; i++)
+    {
+        forward.AddControlVertex(Vector3(i, 0.0, 0.0));
+        backward.AddControlVertex(Vector3(20.0 - i, 0.0, 0.0));
+    }
+    forward.Construct();
+    backward.Construct();
+    SplineDistance distance(forward, backward, 0.25);
+    // Same trace: the Hausdorff distance is zero, the Frechet one is not
+    ASSERT_LT(distance.Hausdorff(1e-4).upper, 1e-3);
+    const DistanceBound frechet = distance.DiscreteFrechet(1e-4);
+    ASSERT_NEAR(20.0, frechet.lower, 1e-3);
+    ASSERT_FALSE(distance.DiscreteFrechetWithin(19.0));
+    ASSERT_TRUE(distance.DiscreteFrechetWithin(20.0 + 1e-6));
+}
+
+TEST(SplineDistance, FrechetOfParallelCurves)
+{
+    CatmullSpline reference;
+    CatmullSpline trajectory;
+    for (int i = 0; i <= 40; i++)
+    {
+        reference.AddControlVertex(Vector3(i, 0.0, 0.0));
+    }
+    // Same line 0.5 to the side, with twice as many vertices
+    for (int i = 0; i <= 80; i++)
+    {
+        trajectory.AddControlVertex(Vector3(0.5*i, 0.5, 0.0));
+    }
+    reference.Construct();
+    trajectory.Construct();
+    SplineDistance distance(trajectory, reference, 0.1);
+    const DistanceBound frechet = distance.DiscreteFrechet(1e-5);
+    ASSERT_NEAR(0.5, frechet.lower, 1e-3);
+    ASSERT_LE(frechet.upper - frechet.lower, 1e-5);
+    ASSERT_TRUE(distance.DiscreteFrechetWithin(0.55));
+    ASSERT_FALSE(distance.DiscreteFrechetWithin(0.45));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
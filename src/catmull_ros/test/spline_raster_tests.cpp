@@ -0,0 +1,148 @@
+/*
+* Testing the rasterization and distance fields of splines
+*/
+#include "../include/catmull_ros/spline_raster.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+static void BuildCurve(CatmullSpline& cspline)
+{
+    // S-shaped path across a 20 x 20 area, leaving the grid on the right
+    for (int i = 0; i <= 26; i++)
+    {
+        cspline.AddControlVertex(Vector3(-1.0 + i, 10.0 + 6.0*sin(0.3*i), 0.0));
+    }
+    cspline.Construct();
+}
+
+static std::vector<Vector3> DenseSamples(CatmullSpline& cspline, int per_segment)
+{
+    std::vector<Vector3> samples;
+    for (int i = 0; i < cspline.GetNumberOfSegments(); i++)
+    {
+        std::shared_ptr<ControlVertex> cv = cspline.GetControlVertex(i);
+        const double t0 = cv->T();
+        const double t1 = cspline.GetSegmentEndT(i);
+        for (int k = 0; k <= per_segment; k++)
+        {
+            samples.push_back(cv->Hermite(t0 + (t1 - t0)*k/per_segment));
+        }
+    }
+    return samples;
+}
+
+TEST(SplineRaster, CoverageIsConservative)
+{
+    CatmullSpline cspline;
+    BuildCurve(cspline);
+    const GridGeometry grid(0.0, 0.0, 0.1, 200, 200);
+    std::vector<std::uint8_t> cells(200*200, 0);
+    const int pieces = RasterizeSpline(cspline, grid, cells.data(), std::uint8_t(1));
+    ASSERT_GT(pieces, 0);
+    const std::vector<Vector3> samples = DenseSamples(cspline, 1000);
+    double length = 0.0;
+    for (std::size_t i = 0; i < samples.size(); i++)
+    {
+        if (i > 0)
+        {
+            length += Distance(samples[i], samples[i - 1]);
+        }
+        const int ix = grid.CellX(samples[i].coords[0]);
+        const int iy = grid.CellY(samples[i].coords[1]);
+        if (ix >= 0 && ix < grid.width && iy >= 0 && iy < grid.height)
+        {
+            ASSERT_EQ(1, cells[grid.Index(ix, iy)]);
+        }
+    }
+    int marked = 0;
+    for (std::size_t i = 0; i < cells.size(); i++)
+    {
+        marked += cells[i];
+    }
+    // A thin band: at most a few cells per cell of path length
+    ASSERT_LT(marked, 4.0*length/grid.resolution);
+}
+
+TEST(SplineRaster, SignedDistanceOfLine)
+{
+    CatmullSpline cspline;
+    for (int i = 0; i <= 10; i++)
+    {
+        cspline.AddControlVertex(Vector3(i, 5.0, 0.0));
+    }
+    cspline.Construct();
+    const GridGeometry grid(0.0, 0.0, 0.5, 20, 20);
+    std::vector<float> field(20*20);
+    BuildDistanceField(cspline, grid, 2.0, true, field.data(), 8);
+    for (int iy = 0; iy < grid.height; iy++)
+    {
+        const double y = grid.CellCenter(5, iy).coords[1];
+        const double expected = std::max(-2.0, std::min(2.0, y - 5.0));
+        ASSERT_NEAR(expected, field[grid.Index(5, iy)], 1e-5);
+    }
+}
+
+TEST(SplineRaster, FarCellsTakeTheirOwnSide)
+{
+    // The tile is wider than twice the band and the line runs near its edge
+    CatmullSpline cspline;
+    for (int i = -2; i <= 18; i++)
+    {
+        cspline.AddControlVertex(Vector3(i, 3.0, 0.0));
+    }
+    cspline.Construct();
+    const GridGeometry grid(0.0, 0.0, 0.5, 32, 32);
+    std::vector<float> field(32*32);
+    BuildDistanceField(cspline, grid, 2.0, true, field.data(), 32);
+    for (int iy = 0; iy < grid.height; iy++)
+    {
+        for (int ix = 0; ix < grid.width; ix += 5)
+        {
+            const double y = grid.CellCenter(ix, iy).coords[1];
+            const double expected = std::max(-2.0, std::min(2.0, y - 3.0));
+            ASSERT_NEAR(expected, field[grid.Index(ix, iy)], 1e-5) << ix << " " << iy;
+        }
+    }
+}
+
+TEST(SplineRaster, DistanceFieldMatchesBruteForce)
+{
+    CatmullSpline cspline;
+    BuildCurve(cspline);
+    const GridGeometry grid(0.0, 0.0, 0.1, 200, 200);
+    const double band = 1.5;
+    std::vector<float> field(200*200);
+    BuildDistanceField(cspline, grid, band, false, field.data());
+    const std::vector<Vector3> samples = DenseSamples(cspline, 200);
+    for (int iy = 0; iy < grid.height; iy += 7)
+    {
+        for (int ix = 0; ix < grid.width; ix += 7)
+        {
+            const Vector3 q = grid.CellCenter(ix, iy);
+            double best = band;
+            for (std::size_t i = 0; i < samples.size(); i++)
+            {
+                best = std::min(best, Distance(q, samples[i]));
+            }
+            ASSERT_NEAR(best, field[grid.Index(ix, iy)], 2e-3);
+        }
+    }
+    const GridGeometry large(0.0, 0.0, 0.04, 500, 500);
+    std::vector<float> large_field(500*500);
+    BuildDistanceField(cspline, large, band, true, large_field.data());
+    // Far away cells are clamped next to the grid
+    ASSERT_EQ(-1, large.CellX(-1e300));
+    ASSERT_EQ(500, large.CellX(1e300));
+    ASSERT_EQ(-1, large.CellY(std::numeric_limits<double>::quiet_NaN()));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
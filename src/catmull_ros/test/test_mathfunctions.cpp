@@ -3,7 +3,12 @@
  * 
 */
 #include "../include/catmull_ros/math_simple.hpp"
+#include "../include/catmull_ros/math_simple_batch.hpp"
 
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
 #include <gtest/gtest.h>
 
 using namespace ros_math_simple;
@@ -33,6 +38,137 @@ TEST(CommonMathTest, clampMaxTest1)
     ASSERT_EQ(1, clamp(2, -2.5, 1));
 }
 
+TEST(CommonMathTest, lerpTest)
+{
+    ASSERT_EQ(1.0, lerp(1.0, 3.0, 0.0));
+    ASSERT_EQ(3.0, lerp(1.0, 3.0, 1.0));
+    ASSERT_EQ(2.5, lerp(1.0, 3.0, 0.75));
+}
+
+TEST(CommonMathTest, smoothstepTest)
+{
+    ASSERT_EQ(0.0, smoothstep(1.0, 2.0, 0.5));
+    ASSERT_EQ(1.0, smoothstep(1.0, 2.0, 2.5));
+    ASSERT_EQ(0.5, smoothstep(1.0, 2.0, 1.5));
+}
+
+TEST(CommonMathTest, wrapAngleTest)
+{
+    ASSERT_DOUBLE_EQ(0.5, wrap_angle(0.5 + 4.0*M_PI));
+    ASSERT_DOUBLE_EQ(-0.5, wrap_angle(-0.5 - 2.0*M_PI));
+    ASSERT_DOUBLE_EQ(-M_PI, wrap_angle(M_PI));
+}
+
+static std::vector<double> BatchTestInput(std::size_t n)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> uniform(-10.0, 10.0);
+    std::vector<double> values(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        values[i] = uniform(generator);
+    }
+    // Special values the scalar clamp handles in a particular way
+    values[0] = std::numeric_limits<double>::quiet_NaN();
+    values[1] = -0.0;
+    values[2] = 0.0;
+    values[3] = std::numeric_limits<double>::infinity();
+    values[4] = -std::numeric_limits<double>::infinity();
+    values[5] = -1.0;
+    values[6] = 1.0;
+    return values;
+}
+
+static bool BitIdentical(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+TEST(CommonMathBatchTest, clampArrayBitIdentical)
+{
+    std::vector<double> in = BatchTestInput(1003);
+    std::vector<double> out(in.size());
+    clamp_array(in.data(), out.data(), in.size(), -1.0, 1.0);
+    for (std::size_t i = 0; i < in.size(); i++)
+    {
+        ASSERT_TRUE(BitIdentical(clamp(in[i], -1.0, 1.0), out[i])) << i;
+    }
+    // Signed zero bounds
+    clamp_array(in.data(), out.data(), in.size(), 0.0, 0.0);
+    for (std::size_t i = 0; i < in.size(); i++)
+    {
+        ASSERT_TRUE(BitIdentical(clamp(in[i], 0.0, 0.0), out[i])) << i;
+    }
+}
+
+TEST(CommonMathBatchTest, clampArrayInPlace)
+{
+    std::vector<double> in = BatchTestInput(17);
+    std::vector<double> expected(in.size());
+    for (std::size_t i = 0; i < in.size(); i++)
+    {
+        expected[i] = clamp(in[i], -2.0, 3.0);
+    }
+    clamp_array(in.data(), in.data(), in.size(), -2.0, 3.0);
+    for (std::size_t i = 0; i < in.size(); i++)
+    {
+        ASSERT_TRUE(BitIdentical(expected[i], in[i])) << i;
+    }
+}
+
+TEST(CommonMathBatchTest, elementwiseKernelsBitIdentical)
+{
+    std::vector<double> a = BatchTestInput(1001);
+    std::vector<double> b(a.rbegin(), a.rend());
+    std::vector<double> out(a.size());
+    lerp_array(a.data(), b.data(), 0.3, out.data(), a.size());
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        ASSERT_TRUE(BitIdentical(lerp(a[i], b[i], 0.3), out[i])) << i;
+    }
+    smoothstep_array(-2.0, 5.0, a.data(), out.data(), a.size());
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        ASSERT_TRUE(BitIdentical(smoothstep(-2.0, 5.0, a[i]), out[i])) << i;
+    }
+    wrap_angle_array(a.data(), out.data(), a.size());
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        ASSERT_TRUE(BitIdentical(wrap_angle(a[i]), out[i])) << i;
+    }
+    rsqrt_array(a.data(), out.data(), a.size());
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        ASSERT_TRUE(BitIdentical(1.0 / sqrt(a[i]), out[i])) << i;
+    }
+}
+
+TEST(CommonMathBatchTest, normalizeArray)
+{
+    std::vector<double> c = BatchTestInput(3*101);
+    std::vector<catmull_ros::Vector3> v;
+    for (std::size_t i = 7; i + 2 < c.size(); i += 3)
+    {
+        v.push_back(catmull_ros::Vector3(c[i], c[i + 1], c[i + 2]));
+    }
+    v[5] = catmull_ros::Vector3();
+    std::vector<catmull_ros::Vector3> expected(v);
+    for (std::size_t i = 0; i < expected.size(); i++)
+    {
+        normalize_scalar(expected[i]);
+    }
+    normalize_array(v.data(), v.size());
+    for (std::size_t i = 0; i < v.size(); i++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            ASSERT_TRUE(BitIdentical(expected[i].coords[k], v[i].coords[k])) << i;
+        }
+    }
+    ASSERT_EQ(0.0, v[5].GetSquaredNorm());
+    ASSERT_NEAR(1.0, v[6].GetSquaredNorm(), 1e-15);
+}
+
 int main(int argc, char **argv){
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
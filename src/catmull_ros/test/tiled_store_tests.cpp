@@ -0,0 +1,229 @@
+/*
+* Testing the tiled spline store and the LRU cache
+*/
+#include "../include/catmull_ros/tiled_spline_store.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const int STORE_ROADS = 40;
+const double STORE_TILE_SIZE = 50.0;
+
+/*
+Grid of wavy roads: east-west roads every 25 m, 400 m long
+*/
+static void BuildRoad(CatmullSpline& cspline, int i)
+{
+    for (int k = 0; k <= 80; k++)
+    {
+        const double x = 5.0*k;
+        cspline.AddControlVertex(Vector3(x, 25.0*i + 3.0*sin(0.05*x + i), 0.0));
+    }
+    cspline.Construct();
+}
+
+static std::string WriteStore()
+{
+    char pattern[] = "/tmp/catmull_tiles_XXXXXX";
+    std::string directory = mkdtemp(pattern);
+    TiledSplineWriter writer(directory, STORE_TILE_SIZE, 1000);
+    for (int i = 0; i < STORE_ROADS; i++)
+    {
+        CatmullSpline cspline;
+        BuildRoad(cspline, i);
+        EXPECT_TRUE(writer.AddSpline(i, cspline));
+    }
+    EXPECT_TRUE(writer.Finish());
+    return directory;
+}
+
+static void RemoveStore(const std::string& directory)
+{
+    ASSERT_EQ(0, std::system(("rm -rf " + directory).c_str()));
+}
+
+TEST(LruCache, EvictsLeastRecentlyUsed)
+{
+    LruCache<int, int> cache(2);
+    cache.Put(1, std::make_shared<const int>(10));
+    cache.Put(2, std::make_shared<const int>(20));
+    std::shared_ptr<const int> held = cache.Get(2);
+    ASSERT_EQ(10, *cache.Get(1));
+    cache.Put(3, std::make_shared<const int>(30));
+    ASSERT_TRUE(cache.Contains(1));
+    ASSERT_FALSE(cache.Contains(2));
+    ASSERT_EQ(nullptr, cache.Get(2));
+    // Evicted values stay valid for their holders
+    ASSERT_EQ(20, *held);
+    ASSERT_EQ(2u, cache.Size());
+}
+
+TEST(TiledStore, EvaluationMatchesSplines)
+{
+    const std::string directory = WriteStore();
+    TiledSplineStore store(directory, 4, 4);
+    ASSERT_TRUE(store.IsOpen());
+    for (int i = 0; i < STORE_ROADS; i += 3)
+    {
+        CatmullSpline cspline;
+        BuildRoad(cspline, i);
+        for (double t = 0.0; t <= cspline.GetMaxT(); t += 3.7)
+        {
+            Vector3 r, dr, ddr;
+            ASSERT_TRUE(store.Evaluate(i, t, r, dr, ddr));
+            ASSERT_LT((cspline.r(t) - r).GetNorm(), 1e-9);
+            ASSERT_LT((cspline.dr(t) - dr).GetNorm(), 1e-9);
+            ASSERT_LT((cspline.ddr(t) - ddr).GetNorm(), 1e-9);
+            ASSERT_LE(store.GetNumberOfCachedTiles(), 4u);
+        }
+    }
+    Vector3 r, dr, ddr;
+    ASSERT_FALSE(store.Evaluate(STORE_ROADS + 1, 0.0, r, dr, ddr));
+    ASSERT_FALSE(store.Evaluate(0, -1.0, r, dr, ddr));
+    RemoveStore(directory);
+}
+
+TEST(TiledStore, WriteWithPendingKnotShifts)
+{
+    char pattern[] = "/tmp/catmull_tiles_XXXXXX";
+    const std::string directory = mkdtemp(pattern);
+    CatmullSpline cspline;
+    BuildRoad(cspline, 0);
+    cspline.InsertControlVertex(2, Vector3(7.0, 40.0, 0.0));
+    ASSERT_NE(0.0, cspline.GetKnotOffset(60));
+    {
+        TiledSplineWriter writer(directory, STORE_TILE_SIZE);
+        ASSERT_TRUE(writer.AddSpline(0, cspline));
+        ASSERT_TRUE(writer.Finish());
+    }
+    TiledSplineStore store(directory, 16);
+    for (int i = 10; i < cspline.GetNumberOfSegments(); i += 10)
+    {
+        const double t = 0.5*(cspline.GetSegmentStartT(i) + cspline.GetSegmentEndT(i));
+        const Vector3 q = cspline.r(t) + Vector3(0.0, 0.5, 0.0);
+        TiledClosestPoint result;
+        ASSERT_TRUE(store.Closest(q, 2.0, result)) << i;
+        ASSERT_LE(result.distance, 0.5 + 1e-9);
+        Vector3 r, dr, ddr;
+        ASSERT_TRUE(store.Evaluate(0, t, r, dr, ddr));
+        ASSERT_LT((cspline.r(t) - r).GetNorm(), 1e-9);
+    }
+    RemoveStore(directory);
+}
+
+TEST(TiledStore, OversizedSegmentsAreRefused)
+{
+    char pattern[] = "/tmp/catmull_tiles_XXXXXX";
+    const std::string directory = mkdtemp(pattern);
+    {
+        TiledSplineWriter writer(directory, STORE_TILE_SIZE);
+        // A single segment across 2e7 tiles
+        CatmullSpline huge;
+        huge.AddControlVertex(Vector3(0.0, 0.0, 0.0));
+        huge.AddControlVertex(Vector3(1e9, 0.0, 0.0));
+        huge.Construct();
+        ASSERT_FALSE(writer.AddSpline(0, huge));
+        // Beyond the tile coordinate range, but within a single tile
+        CatmullSpline far;
+        far.AddControlVertex(Vector3(1e15, 1e15, 0.0));
+        far.AddControlVertex(Vector3(1e15 + 10.0, 1e15, 0.0));
+        far.Construct();
+        ASSERT_TRUE(writer.AddSpline(1, far));
+        CatmullSpline road;
+        BuildRoad(road, 0);
+        ASSERT_TRUE(writer.AddSpline(2, road));
+        ASSERT_TRUE(writer.Finish());
+    }
+    TiledSplineStore store(directory, 16);
+    Vector3 r, dr, ddr;
+    ASSERT_FALSE(store.Evaluate(0, 1.0, r, dr, ddr));
+    ASSERT_TRUE(store.Evaluate(2, 1.0, r, dr, ddr));
+    RemoveStore(directory);
+}
+
+TEST(TiledStore, ClosestAcrossTileBorders)
+{
+    const std::string directory = WriteStore();
+    TiledSplineStore store(directory, 6);
+    std::vector<CatmullSpline> roads(STORE_ROADS);
+    for (int i = 0; i < STORE_ROADS; i++)
+    {
+        BuildRoad(roads[i], i);
+    }
+    for (int k = 0; k < 200; k++)
+    {
+        // Points on and around the tile borders
+        const Vector3 q(49.0 + 0.009*k*k, 12.5 + 4.9*k, 0.0);
+        TiledClosestPoint result;
+        ASSERT_TRUE(store.Closest(q, 20.0, result));
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < STORE_ROADS; i++)
+        {
+            for (int j = 0; j < roads[i].GetNumberOfSegments(); j++)
+            {
+                std::shared_ptr<ControlVertex> cv = roads[i].GetControlVertex(j);
+                const double t = cv->ClosestParameter(q, roads[i].GetSegmentEndT(j));
+                best = std::min(best, Distance(cv->Hermite(t), q));
+            }
+        }
+        ASSERT_NEAR(best, result.distance, 1e-9) << k;
+        ASSERT_LE(store.GetNumberOfCachedTiles(), 6u);
+    }
+    TiledClosestPoint result;
+    ASSERT_FALSE(store.Closest(Vector3(200.0, -100.0, 0.0), 10.0, result));
+    RemoveStore(directory);
+}
+
+TEST(TiledStore, UnboundedQueriesAreLimited)
+{
+    TiledSplineStore missing("/tmp/catmull_tiles_missing", 4);
+    ASSERT_FALSE(missing.IsOpen());
+    TiledClosestPoint result;
+    ASSERT_FALSE(missing.Closest(Vector3(), 10.0, result));
+    missing.Prefetch(Vector3(), Vector3(1.0, 0.0, 0.0), 10.0);
+    missing.WaitForPrefetch();
+    ASSERT_EQ(0u, missing.GetNumberOfLoads());
+    const std::string directory = WriteStore();
+    TiledSplineStore store(directory, 16);
+    const double inf = std::numeric_limits<double>::infinity();
+    ASSERT_TRUE(store.Closest(Vector3(120.0, 45.0, 0.0), inf, result));
+    ASSERT_EQ(2u, result.spline);
+    ASSERT_FALSE(store.Closest(Vector3(120.0, 45.0, 0.0), std::nan(""), result));
+    ASSERT_LE(store.GetNumberOfLoads(), 65u*65u);
+    const std::size_t loads = store.GetNumberOfLoads();
+    store.Prefetch(Vector3(10.0, 10.0, 0.0), Vector3(inf, 0.0, 0.0), 1.0);
+    store.Prefetch(Vector3(10.0, 10.0, 0.0), Vector3(1.0, 0.0, 0.0), inf);
+    store.WaitForPrefetch();
+    ASSERT_LE(store.GetNumberOfLoads(), loads + 3u*3u*257u);
+    RemoveStore(directory);
+}
+
+TEST(TiledStore, PrefetchAheadOfMotion)
+{
+    const std::string directory = WriteStore();
+    TiledSplineStore store(directory, 64);
+    store.Prefetch(Vector3(10.0, 10.0, 0.0), Vector3(10.0, 0.0, 0.0), 20.0);
+    store.WaitForPrefetch();
+    ASSERT_TRUE(store.IsTileCached(0, 0));
+    ASSERT_TRUE(store.IsTileCached(4, 0));
+    ASSERT_TRUE(store.IsTileCached(4, 1));
+    ASSERT_FALSE(store.IsTileCached(7, 0));
+    const std::size_t loads = store.GetNumberOfLoads();
+    Vector3 r, dr, ddr;
+    // The tiles along the road are already resident
+    ASSERT_TRUE(store.Evaluate(0, 150.0, r, dr, ddr));
+    ASSERT_EQ(loads, store.GetNumberOfLoads());
+    RemoveStore(directory);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,129 @@
+/*
+* Testing the trajectory cursor
+*/
+#include "../include/catmull_ros/trajectory_cursor.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace catmull_ros;
+
+const double CURSOR_EPS = 1e-9;
+
+static void BuildWave(CatmullSpline& cspline)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        cspline.AddControlVertex(Vector3(1.0*i, 2.0*sin(0.5*i), 0.0));
+    }
+    cspline.Construct();
+}
+
+static void BuildCircle(CatmullSpline& cspline)
+{
+    for (int i = 0; i < 12; i++)
+    {
+        const double phi = 2.0*M_PI*i/12.0;
+        cspline.AddControlVertex(Vector3(5.0*cos(phi), 5.0*sin(phi), 0.0));
+    }
+    cspline.ConstructLoop();
+}
+
+TEST(SplineCursorBasic, FindSegmentMatchesKnots)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline);
+    ASSERT_EQ(-1, cspline.FindSegment(-1.0));
+    ASSERT_EQ(0, cspline.FindSegment(0.0));
+    for (int i = 0; i < 19; i++)
+    {
+        const double t = cspline.GetControlVertex(i)->T();
+        ASSERT_EQ(i, cspline.FindSegment(t));
+        ASSERT_EQ(i, cspline.FindSegment(t + 1e-6));
+    }
+    ASSERT_EQ(18, cspline.FindSegment(cspline.GetMaxT()));
+    ASSERT_EQ(-1, cspline.FindSegment(cspline.GetMaxT() + 1.0));
+}
+
+TEST(SplineCursorBasic, AdvanceMatchesEvaluation)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline);
+    SplineCursor cursor(cspline);
+    double t = 0.0;
+    while (cursor.Advance(0.013))
+    {
+        t += 0.013;
+        ASSERT_NEAR(t, cursor.T(), CURSOR_EPS);
+        Vector3 expected = cspline.r(cursor.T());
+        ASSERT_LT((expected - cursor.Position()).GetNorm(), CURSOR_EPS);
+        ASSERT_LT((cspline.dr(cursor.T()) - cursor.Velocity()).GetNorm(), CURSOR_EPS);
+    }
+    ASSERT_TRUE(cursor.AtEnd());
+    ASSERT_DOUBLE_EQ(cspline.GetMaxT(), cursor.T());
+}
+
+TEST(SplineCursorBasic, StepMatchesEvaluation)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline);
+    SplineCursor cursor(cspline);
+    cursor.SetStep(0.01);
+    while (cursor.Step())
+    {
+        Vector3 expected = cspline.r(cursor.T());
+        ASSERT_LT((expected - cursor.Position()).GetNorm(), 1e-7);
+    }
+}
+
+TEST(SplineCursorBasic, ClosedLoopWrapsAround)
+{
+    CatmullSpline cspline;
+    BuildCircle(cspline);
+    SplineCursor cursor(cspline);
+    cursor.Seek(cspline.GetMaxT() - 0.1);
+    ASSERT_EQ(11, cursor.Segment());
+    ASSERT_TRUE(cursor.Advance(0.3));
+    ASSERT_EQ(0, cursor.Segment());
+    ASSERT_NEAR(0.2, cursor.T(), CURSOR_EPS);
+    ASSERT_LT((cspline.r(0.2) - cursor.Position()).GetNorm(), CURSOR_EPS);
+    ASSERT_TRUE(cursor.Advance(-0.4));
+    ASSERT_EQ(11, cursor.Segment());
+}
+
+TEST(SplineCursorBasic, ArcLengthAdvance)
+{
+    CatmullSpline cspline;
+    BuildCircle(cspline);
+    SplineCursor cursor(cspline);
+    // On a circle the travelled chord determines the travelled arc
+    for (int i = 0; i < 100; i++)
+    {
+        Vector3 before = cursor.Position();
+        cursor.AdvanceArcLength(0.1);
+        const double chord = (cursor.Position() - before).GetNorm();
+        ASSERT_NEAR(2.0*5.0*sin(0.1/(2.0*5.0)), chord, 2e-3);
+    }
+}
+
+TEST(SplineCursorBasic, RangeForSampling)
+{
+    CatmullSpline cspline;
+    BuildWave(cspline);
+    SplineSamples samples(cspline, 0.5);
+    int count = 0;
+    for (const Vector3& p : samples)
+    {
+        Vector3 expected = cspline.r(0.5*count);
+        ASSERT_LT((expected - p).GetNorm(), 1e-7);
+        count++;
+    }
+    ASSERT_EQ(samples.Size(), count);
+    ASSERT_EQ(static_cast<int>(floor(cspline.GetMaxT()/0.5)) + 1, count);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}